@@ -0,0 +1,84 @@
+#pragma once
+
+#include <string>
+#include <vector>
+#include <mcr/io/IWriter.h>
+
+namespace bench {
+
+using mcr::byte;
+using mcr::uint;
+using mcr::uint64;
+
+//! Runs the workload \c numIterations times; per-benchmark state that's
+//! expensive to set up goes into function statics, built on the first call
+typedef void (*Fn)(uint64 numIterations);
+
+enum Flags
+{
+    NeedsGL = 0x1 // run on a headless context, skipped if there's none
+};
+
+struct Benchmark
+{
+    const char* name;
+    Fn          fn;
+    uint        flags;
+};
+
+std::vector<Benchmark>& registry();
+
+struct Registrar
+{
+    Registrar(const char* name, Fn fn, uint flags = 0)
+    {
+        Benchmark benchmark = {name, fn, flags};
+        registry().push_back(benchmark);
+    }
+};
+
+extern volatile byte g_sink;
+
+//! Wait for the GL benchmarks' commands to execute, so that they are timed
+void finishGL();
+
+//! Keep the compiler from dropping the computation of \c value
+template <typename T>
+inline void keep(const T& value)
+{
+    g_sink ^= *reinterpret_cast<const volatile byte*>(&value);
+}
+
+//! Collects what's written, or drops it when told to
+class BufferWriter: public mcr::io::IWriter
+{
+public:
+    using RefCounted::operator new;
+    using RefCounted::operator delete;
+
+    BufferWriter(bool discard = false): m_discard(discard) {}
+
+    std::size_t write(const void* buffer, std::size_t size)
+    {
+        if (!m_discard)
+            m_data.append(static_cast<const char*>(buffer), size);
+
+        return size;
+    }
+
+    const std::string& data() const { return m_data; }
+    void               clear()      { m_data.clear(); }
+
+private:
+    std::string m_data;
+    bool        m_discard;
+};
+
+} // ns bench
+
+//! Define and register a benchmark; \c fn names the function, the body
+//! follows and sees \c numIterations
+#define MCR_BENCHMARK(fn, name, flags) \
+    static void fn(bench::uint64 numIterations); \
+    static const bench::Registrar fn##Registrar(name, fn, flags); \
+    static void fn(bench::uint64 numIterations)
@@ -0,0 +1,185 @@
+// Text parsing, stream reading and logging, all from and to memory so that
+// the file system stays out of the numbers
+
+#include "Bench.h"
+
+#include <cstdio>
+#include <string>
+
+#include <mcr/Config.h>
+#include <mcr/Log.h>
+#include <mcr/io/LineParser.h>
+#include <mcr/io/MemoryReader.h>
+
+using namespace mcr;
+
+namespace {
+
+//! A config-like text of \c numLines "key: value" lines, some indented
+std::string makeText(int numLines)
+{
+    std::string text;
+    char line[64];
+
+    for (int i = 0; i < numLines; ++i)
+    {
+        std::sprintf(line, "%svariable_%d: %d.%d\n", i % 4 ? "" : "    ", i, i * 7, i % 10);
+        text += line;
+    }
+
+    return text;
+}
+
+const std::string& text()
+{
+    static const std::string s_text = makeText(4096);
+    return s_text;
+}
+
+rcptr<io::MemoryReader> textReader()
+{
+    return new io::MemoryReader("bench.yaml", text().data(), text().size());
+}
+
+} // ns
+
+
+//////////////////////////////////////////////////////////////////////////
+// Reading
+
+MCR_BENCHMARK(lineParserReadLine, "io/LineParser.readLine", 0)
+{
+    auto reader = textReader();
+    io::LineParser parser(reader);
+
+    std::size_t length = 0;
+
+    for (uint64 i = 0; i < numIterations; ++i)
+    {
+        if (!parser.readLine())
+        {
+            reader->seek(0);
+            parser = io::LineParser(reader);
+            parser.readLine();
+        }
+
+        length += parser.length();
+    }
+
+    bench::keep(length);
+}
+
+MCR_BENCHMARK(readStringTerminated, "io/IReader.readString", 0)
+{
+    auto reader = textReader();
+
+    std::string line;
+    std::size_t length = 0;
+
+    for (uint64 i = 0; i < numIterations; ++i)
+    {
+        if (!reader->readString(line, '\n'))
+        {
+            reader->seek(0);
+            reader->readString(line, '\n');
+        }
+
+        length += line.size();
+    }
+
+    bench::keep(length);
+}
+
+
+//////////////////////////////////////////////////////////////////////////
+// Config, one load is 256 lines
+
+namespace {
+
+const std::string& configText()
+{
+    static const std::string s_text = makeText(256);
+    return s_text;
+}
+
+} // ns
+
+MCR_BENCHMARK(configLoad, "config/Config.load", 0)
+{
+    rcptr<io::MemoryReader> reader = new io::MemoryReader("bench.yaml", configText().data(), configText().size());
+
+    for (uint64 i = 0; i < numIterations; ++i)
+    {
+        Config config;
+
+        reader->seek(0);
+        bench::keep(config.load(reader, false));
+    }
+}
+
+MCR_BENCHMARK(configQuery, "config/Config.query", 0)
+{
+    static Config s_config;
+    static bool   s_loaded = s_config.load(
+        new io::MemoryReader("bench.yaml", configText().data(), configText().size()), false);
+
+    static const std::string s_keys[] = {"variable_3", "variable_128", "variable_255", "missing"};
+
+    float sum = 0, value;
+
+    for (uint64 i = 0; i < numIterations; ++i)
+    {
+        s_config.query(s_keys[i % 4], value, 1.f);
+        sum += value;
+    }
+
+    bench::keep(sum);
+    bench::keep(s_loaded);
+}
+
+
+//////////////////////////////////////////////////////////////////////////
+// Logging into memory, formatting included
+
+namespace {
+
+std::size_t logPrint(Log& log, const char* fmt, ...)
+{
+    std::va_list args;
+    va_start(args, fmt);
+
+    auto bytes = log.vprint(Log::Info, fmt, args);
+
+    va_end(args);
+    return bytes;
+}
+
+} // ns
+
+MCR_BENCHMARK(logVprint, "log/Log.vprint", 0)
+{
+    Log log;
+    log.setStdOutEnabled(false);
+    log.setStream(new bench::BufferWriter(true));
+
+    std::size_t bytes = 0;
+
+    for (uint64 i = 0; i < numIterations; ++i)
+        bytes += logPrint(log, "Frame %llu: %.3f ms, %u draws", (unsigned long long) i, i * .001, (uint) i % 1000);
+
+    bench::keep(bytes);
+}
+
+MCR_BENCHMARK(logVprintFiltered, "log/Log.vprint.filtered", 0)
+{
+    Log log;
+    log.setStdOutEnabled(false);
+    log.setVerbosity(Log::Warnings);
+
+    std::size_t bytes = 0;
+
+    for (uint64 i = 0; i < numIterations; ++i)
+        bytes += logPrint(log, "Frame %llu: %.3f ms, %u draws", (unsigned long long) i, i * .001, (uint) i % 1000);
+
+    bench::keep(bytes);
+}
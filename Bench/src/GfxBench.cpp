@@ -0,0 +1,208 @@
+// Parameter updates, draws and mesh (de)serialization on the headless
+// context, plus vertex format parsing, which needs no GL
+
+#include "Bench.h"
+
+#include <vector>
+
+#include <mcr/io/MemoryReader.h>
+#include <mcr/gfx/Renderer.h>
+#include <mcr/gfx/geom/Mesh.h>
+#include <mcr/gfx/geom/mem/NaiveMemory.h>
+#include <mcr/gfx/mtl/Manager.h>
+
+using namespace mcr;
+using namespace gfx;
+
+namespace {
+
+const char* const g_vertexSource =
+    "#version 330\n"
+    "layout(location = 0) in vec3 Position;\n"
+    "uniform vec4 Offset;\n"
+    "void main() { gl_Position = vec4(Position + Offset.xyz, 1); }\n";
+
+const char* const g_fragmentSource =
+    "#version 330\n"
+    "uniform vec4 Tint;\n"
+    "out vec4 Color;\n"
+    "void main() { Color = Tint; }\n";
+
+const uint GridSize = 32; // quads a side, two triangles each
+
+//! A material with a couple of uniforms and a grid mesh using it, made once
+//! the headless context is there
+struct Fixture
+{
+    mtl::Manager                manager;
+    rcptr<mtl::Material>        material;
+    rcptr<mtl::ParamBuffer>     params;
+
+    geom::mem::NaiveMemory      vertexMem, indexMem;
+    geom::Mesh                  mesh;
+
+    Renderer                    renderer;
+
+    Fixture():
+        vertexMem(geom::mem::NaiveMemory::Vertex, geom::mem::NaiveMemory::Static),
+        indexMem(geom::mem::NaiveMemory::Index, geom::mem::NaiveMemory::Static)
+    {
+        auto vs = mtl::Shader::create(mtl::Shader::Vertex);
+        auto fs = mtl::Shader::create(mtl::Shader::Fragment);
+
+        vs->setSource(g_vertexSource);
+        fs->setSource(g_fragmentSource);
+
+        material = mtl::Material::create(&manager);
+        material->setShaders(mtl::ShaderList().add(vs).add(fs));
+
+        params = mtl::ParamBuffer::create(
+            "Bench", mtl::ParamLayout()
+                .addMat4("Model")
+                .addVec4("Color")
+                .addFloat("Time"));
+
+        std::vector<vec3> vertices;
+        std::vector<uint> indices;
+
+        for (uint y = 0; y <= GridSize; ++y)
+            for (uint x = 0; x <= GridSize; ++x)
+                vertices.push_back(vec3(x * 2.f / GridSize - 1, y * 2.f / GridSize - 1, 0));
+
+        for (uint y = 0; y < GridSize; ++y)
+        {
+            for (uint x = 0; x < GridSize; ++x)
+            {
+                uint corner = y * (GridSize + 1) + x;
+                uint quad[] = {corner, corner + 1, corner + GridSize + 2, corner, corner + GridSize + 2, corner + GridSize + 1};
+
+                indices.insert(indices.end(), quad, quad + 6);
+            }
+        }
+
+        mesh.vertexFormat = geom::VertexFormat("3f");
+        mesh.vertices     = vertexMem.allocate(vertices.size() * sizeof(vec3));
+        mesh.indices      = indexMem.allocate(indices.size() * sizeof(uint));
+
+        mesh.vertices->write(0, vertices.size() * sizeof(vec3), &vertices[0]);
+        mesh.indices->write(0, indices.size() * sizeof(uint), &indices[0]);
+    }
+};
+
+Fixture& fixture()
+{
+    static Fixture s_fixture;
+    return s_fixture;
+}
+
+} // ns
+
+
+//////////////////////////////////////////////////////////////////////////
+// Parameters
+
+MCR_BENCHMARK(setParamByName, "gfx/ParamBufferBase.setParam.name", bench::NeedsGL)
+{
+    auto params = fixture().params;
+
+    constexpr Name timeParam("Time");
+
+    for (uint64 i = 0; i < numIterations; ++i)
+        params->setParam(timeParam, float(i));
+}
+
+MCR_BENCHMARK(setParamByIndex, "gfx/ParamBufferBase.setParam.index", bench::NeedsGL)
+{
+    auto params = fixture().params;
+    auto index  = params->findParam("Time");
+
+    for (uint64 i = 0; i < numIterations; ++i)
+        params->setParam(index, float(i));
+}
+
+MCR_BENCHMARK(syncParams, "gfx/Material.syncParams", bench::NeedsGL)
+{
+    auto material = fixture().material;
+
+    constexpr Name tintParam("Tint"), offsetParam("Offset");
+
+    for (uint64 i = 0; i < numIterations; ++i)
+    {
+        material->setParam(tintParam, vec4(float(i & 255) / 255, 0, 0, 1));
+        material->setParam(offsetParam, vec4(0, 0, float(i & 1), 0));
+        material->syncParams();
+    }
+
+    bench::finishGL();
+}
+
+
+//////////////////////////////////////////////////////////////////////////
+// Drawing, one iteration is 2048 triangles
+
+MCR_BENCHMARK(drawMesh, "gfx/Renderer.drawMesh", bench::NeedsGL)
+{
+    auto& f = fixture();
+
+    f.renderer.setActiveMaterial(f.material);
+
+    for (uint64 i = 0; i < numIterations; ++i)
+        f.renderer.drawMesh(f.mesh);
+
+    f.renderer.endFrame();
+    bench::finishGL();
+}
+
+
+//////////////////////////////////////////////////////////////////////////
+// Meshes, in memory
+
+MCR_BENCHMARK(meshSave, "gfx/Mesh.save", bench::NeedsGL)
+{
+    auto& f = fixture();
+    rcptr<bench::BufferWriter> writer = new bench::BufferWriter;
+
+    for (uint64 i = 0; i < numIterations; ++i)
+    {
+        writer->clear();
+        bench::keep(geom::Mesh::save(writer, f.mesh));
+    }
+}
+
+MCR_BENCHMARK(meshLoad, "gfx/Mesh.load", bench::NeedsGL)
+{
+    auto& f = fixture();
+
+    static std::string s_saved;
+
+    if (s_saved.empty())
+    {
+        rcptr<bench::BufferWriter> writer = new bench::BufferWriter;
+        geom::Mesh::save(writer, f.mesh);
+        s_saved = writer->data();
+    }
+
+    for (uint64 i = 0; i < numIterations; ++i)
+    {
+        rcptr<io::MemoryReader> reader = new io::MemoryReader("bench.mesh", s_saved.data(), s_saved.size());
+
+        geom::Mesh mesh;
+        bench::keep(geom::Mesh::load(reader, &f.vertexMem, &f.indexMem, mesh));
+    }
+}
+
+
+//////////////////////////////////////////////////////////////////////////
+// Vertex formats
+
+MCR_BENCHMARK(parseVertexFormat, "gfx/VertexFormat.parse", 0)
+{
+    static const char* const s_formats[] = {"3f", "3f3f2f", "p3f n3f t2f c4ub", "3f_2us4ub4ub"};
+
+    uint stride = 0;
+
+    for (uint64 i = 0; i < numIterations; ++i)
+        stride += geom::VertexFormat(s_formats[i % 4]).stride();
+
+    bench::keep(stride);
+}
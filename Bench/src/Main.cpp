@@ -0,0 +1,298 @@
+// Runs the registered benchmarks and reports the median time per iteration
+// over a number of samples, each long enough for the timer not to matter:
+//
+//     massacre-bench [--filter <text>] [--samples <n>] [--sample-ms <ms>]
+//                    [--baseline <file>] [--save <file>] [--no-gl] [--list]
+//
+// With --baseline, each result is compared with the one saved by an earlier
+// --save, and flagged where the difference is beyond the noise.
+
+#include "Bench.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <map>
+
+#include <mcr/Log.h>
+#include <mcr/Timer.h>
+#include <mcr/math/Simd.h>
+#include <mcr/gfx/HeadlessContext.h>
+
+using namespace mcr;
+
+namespace bench {
+
+volatile byte g_sink;
+
+// Outlives the benchmarks' statics, which may hold GL objects
+gfx::HeadlessContext g_context;
+
+void finishGL()
+{
+    g_context.finish();
+}
+
+std::vector<Benchmark>& registry()
+{
+    static std::vector<Benchmark> s_benchmarks;
+    return s_benchmarks;
+}
+
+} // ns bench
+
+namespace {
+
+struct Options
+{
+    const char* filter;
+    const char* baselineFile;
+    const char* saveFile;
+    int         numSamples;
+    double      sampleMs;
+    bool        gl;
+    bool        list;
+
+    Options(): filter(""), baselineFile(), saveFile(), numSamples(15), sampleMs(20), gl(true), list() {}
+};
+
+struct Result
+{
+    double median, min;
+    double spread; // median absolute deviation, relative to the median
+};
+
+typedef std::map<std::string, double> Baseline;
+
+double nsPerIteration(const bench::Benchmark& benchmark, uint64 numIterations)
+{
+    Timer timer;
+    timer.start();
+
+    benchmark.fn(numIterations);
+
+    timer.refresh();
+    return 1e9 * timer.seconds() / numIterations;
+}
+
+double median(std::vector<double> values)
+{
+    std::sort(values.begin(), values.end());
+
+    auto mid = values.size() / 2;
+    return values.size() % 2 ? values[mid] : (values[mid - 1] + values[mid]) / 2;
+}
+
+Result measure(const bench::Benchmark& benchmark, const Options& options)
+{
+    // Grow the iteration count until a sample takes long enough; the first
+    // calls also build whatever the benchmark sets up once
+    uint64 numIterations = 1;
+
+    for (;;)
+    {
+        auto ms = nsPerIteration(benchmark, numIterations) * numIterations / 1e6;
+
+        if (ms >= options.sampleMs)
+            break;
+
+        auto scale = ms > 0 ? 1.2 * options.sampleMs / ms : 10.;
+        numIterations = std::max(numIterations + 1, (uint64) (numIterations * std::min(scale, 10.)));
+    }
+
+    std::vector<double> samples, deviations;
+
+    for (int i = 0; i < options.numSamples; ++i)
+        samples.push_back(nsPerIteration(benchmark, numIterations));
+
+    Result result;
+    result.median = median(samples);
+    result.min    = *std::min_element(samples.begin(), samples.end());
+
+    for (auto it = samples.begin(); it != samples.end(); ++it)
+        deviations.push_back(std::fabs(*it - result.median));
+
+    result.spread = result.median > 0 ? median(deviations) / result.median : 0;
+    return result;
+}
+
+std::string formatTime(double ns)
+{
+    char buffer[32];
+
+    if (ns < 1e3)
+        std::sprintf(buffer, "%.2f ns", ns);
+    else if (ns < 1e6)
+        std::sprintf(buffer, "%.2f us", ns / 1e3);
+    else
+        std::sprintf(buffer, "%.2f ms", ns / 1e6);
+
+    return buffer;
+}
+
+bool loadBaseline(const char* filename, Baseline& baseline)
+{
+    auto file = std::fopen(filename, "r");
+    if (!file)
+        return false;
+
+    char   name[256];
+    double ns;
+
+    while (std::fscanf(file, "%255s %lf", name, &ns) == 2)
+        baseline[name] = ns;
+
+    std::fclose(file);
+    return true;
+}
+
+bool saveBaseline(const char* filename, const Baseline& results)
+{
+    auto file = std::fopen(filename, "w");
+    if (!file)
+        return false;
+
+    for (auto it = results.begin(); it != results.end(); ++it)
+        std::fprintf(file, "%s %.4f\n", it->first.c_str(), it->second);
+
+    std::fclose(file);
+    return true;
+}
+
+bool parseOptions(int argc, char** argv, Options& options)
+{
+    for (int i = 1; i < argc; ++i)
+    {
+        auto arg   = argv[i];
+        auto value = i + 1 < argc ? argv[i + 1] : nullptr;
+
+        if (!std::strcmp(arg, "--no-gl"))
+            options.gl = false;
+        else if (!std::strcmp(arg, "--list"))
+            options.list = true;
+        else if (!value)
+            return false;
+        else if (!std::strcmp(arg, "--filter"))
+            options.filter = argv[++i];
+        else if (!std::strcmp(arg, "--baseline"))
+            options.baselineFile = argv[++i];
+        else if (!std::strcmp(arg, "--save"))
+            options.saveFile = argv[++i];
+        else if (!std::strcmp(arg, "--samples"))
+            options.numSamples = std::max(1, std::atoi(argv[++i]));
+        else if (!std::strcmp(arg, "--sample-ms"))
+            options.sampleMs = std::max(1., std::atof(argv[++i]));
+        else
+            return false;
+    }
+
+    return true;
+}
+
+} // ns
+
+
+int main(int argc, char** argv)
+{
+    Options options;
+
+    if (!parseOptions(argc, argv, options))
+    {
+        std::fprintf(stderr, "usage: massacre-bench [--filter <text>] [--samples <n>] [--sample-ms <ms>] "
+                             "[--baseline <file>] [--save <file>] [--no-gl] [--list]\n");
+        return 1;
+    }
+
+    auto benchmarks = bench::registry();
+
+    std::sort(benchmarks.begin(), benchmarks.end(),
+        [] (const bench::Benchmark& a, const bench::Benchmark& b) { return std::strcmp(a.name, b.name) < 0; });
+
+    if (options.list)
+    {
+        for (auto it = benchmarks.begin(); it != benchmarks.end(); ++it)
+            std::printf("%s%s\n", it->name, it->flags & bench::NeedsGL ? " (GL)" : "");
+
+        return 0;
+    }
+
+    Baseline baseline, results;
+
+    if (options.baselineFile && !loadBaseline(options.baselineFile, baseline))
+        std::fprintf(stderr, "massacre-bench: can't read baseline '%s'\n", options.baselineFile);
+
+    g_log->setVerbosity(Log::Warnings);
+
+    auto& context = bench::g_context;
+    bool triedContext = false;
+
+#if defined(MCR_MATH_SSE)
+    std::printf("SIMD: SSE\n\n");
+#elif defined(MCR_MATH_NEON)
+    std::printf("SIMD: NEON\n\n");
+#else
+    std::printf("SIMD: none, the .simd kernels run the scalar code\n\n");
+#endif
+
+    std::printf("%-36s %12s %12s %8s %16s\n", "benchmark", "median", "min", "spread", "vs baseline");
+
+    int numSlower = 0, numFaster = 0;
+
+    for (auto it = benchmarks.begin(); it != benchmarks.end(); ++it)
+    {
+        if (!std::strstr(it->name, options.filter))
+            continue;
+
+        if (it->flags & bench::NeedsGL)
+        {
+            if (options.gl && !triedContext)
+            {
+                triedContext = true;
+
+                if (!context.create(ivec2(256, 256)))
+                    std::fprintf(stderr, "massacre-bench: no headless GL context, skipping GL benchmarks\n");
+            }
+
+            if (!context.isValid())
+                continue;
+        }
+
+        auto result = measure(*it, options);
+        results[it->name] = result.median;
+
+        std::printf("%-36s %12s %12s %7.1f%%", it->name,
+            formatTime(result.median).c_str(), formatTime(result.min).c_str(), 100 * result.spread);
+
+        auto base = baseline.find(it->name);
+
+        if (base != baseline.end() && base->second > 0)
+        {
+            auto delta = result.median / base->second - 1;
+
+            // Within three deviations, or 2%, it's noise
+            auto noise   = std::max(3 * result.spread, .02);
+            auto verdict = delta > noise ? "slower" : delta < -noise ? "faster" : "";
+
+            numSlower += delta > noise;
+            numFaster += delta < -noise;
+
+            std::printf(" %+8.1f%% %-7s", 100 * delta, verdict);
+        }
+
+        std::printf("\n");
+        std::fflush(stdout);
+    }
+
+    if (!baseline.empty())
+        std::printf("\n%d slower, %d faster than the baseline\n", numSlower, numFaster);
+
+    if (options.saveFile && !saveBaseline(options.saveFile, results))
+    {
+        std::fprintf(stderr, "massacre-bench: can't write '%s'\n", options.saveFile);
+        return 1;
+    }
+
+    return 0;
+}
@@ -0,0 +1,210 @@
+// The scalar 4x4 kernels next to the SIMD ones they are replaced with,
+// the Matrix4x4 and Vector operations built on them, and per-element
+// loops next to the batch kernels
+
+#include "Bench.h"
+
+#include <cstdlib>
+#include <cstring>
+#include <vector>
+
+#include <mcr/ThreadPool.h>
+#include <mcr/math/Batch.h>
+#include <mcr/math/Matrix.h>
+
+using namespace mcr;
+using namespace math::detail;
+
+namespace {
+
+const int NumMatrices = 1024;
+
+struct Matrices
+{
+    std::vector<mat4> inputs, results;
+    std::vector<vec3> vectors;
+
+    Matrices():
+        inputs(NumMatrices, mat4(false)),
+        results(NumMatrices, mat4(false)),
+        vectors(NumMatrices)
+    {
+        std::srand(1);
+
+        for (int i = 0; i < NumMatrices; ++i)
+        {
+            for (int j = 0; j < 16; ++j)
+                inputs[i][j] = std::rand() / float(RAND_MAX) - .5f;
+
+            vectors[i] = vec3(inputs[i][0], inputs[i][1], inputs[i][2]);
+        }
+    }
+};
+
+Matrices& matrices()
+{
+    static Matrices s_matrices;
+    return s_matrices;
+}
+
+//! One iteration applies \c fn to a pair of matrices
+template <typename Fn>
+void runKernel(uint64 numIterations, Fn fn)
+{
+    auto& m = matrices();
+
+    for (uint64 i = 0; i < numIterations; ++i)
+    {
+        auto j = i % NumMatrices;
+        fn(&m.inputs[j][0], &m.inputs[(j + 1) % NumMatrices][0], &m.results[j][0]);
+    }
+
+    bench::keep(m.results[numIterations % NumMatrices][5]);
+}
+
+} // ns
+
+
+//////////////////////////////////////////////////////////////////////////
+// Kernels
+
+MCR_BENCHMARK(multiplyScalar, "math/multiply4x4.scalar", 0)
+{
+    runKernel(numIterations, [] (const float* a, const float* b, float* out) { multiply4x4<float>(a, b, out); });
+}
+
+MCR_BENCHMARK(multiplySimd, "math/multiply4x4.simd", 0)
+{
+    runKernel(numIterations, [] (const float* a, const float* b, float* out) { multiply4x4(a, b, out); });
+}
+
+MCR_BENCHMARK(transformScalar, "math/transform4.scalar", 0)
+{
+    runKernel(numIterations, [] (const float* a, const float* b, float* out) { transform4<float>(a, b, out); });
+}
+
+MCR_BENCHMARK(transformSimd, "math/transform4.simd", 0)
+{
+    runKernel(numIterations, [] (const float* a, const float* b, float* out) { transform4(a, b, out); });
+}
+
+MCR_BENCHMARK(transposeScalar, "math/transpose4x4.scalar", 0)
+{
+    runKernel(numIterations, [] (const float* a, const float*, float* out) { std::memcpy(out, a, 64); transpose4x4<float>(out); });
+}
+
+MCR_BENCHMARK(transposeSimd, "math/transpose4x4.simd", 0)
+{
+    runKernel(numIterations, [] (const float* a, const float*, float* out) { std::memcpy(out, a, 64); transpose4x4(out); });
+}
+
+MCR_BENCHMARK(inverseScalar, "math/inverse4x4.scalar", 0)
+{
+    runKernel(numIterations, [] (const float* a, const float*, float* out) { inverse4x4<float>(a, out); });
+}
+
+MCR_BENCHMARK(inverseSimd, "math/inverse4x4.simd", 0)
+{
+    runKernel(numIterations, [] (const float* a, const float*, float* out) { inverse4x4(a, out); });
+}
+
+
+//////////////////////////////////////////////////////////////////////////
+// Matrix4x4 and Vector
+
+MCR_BENCHMARK(matrixMultiply, "math/mat4.multiply", 0)
+{
+    auto& m = matrices();
+
+    for (uint64 i = 0; i < numIterations; ++i)
+    {
+        auto j = i % NumMatrices;
+        m.results[j] = m.inputs[j] * m.inputs[(j + 1) % NumMatrices];
+    }
+
+    bench::keep(m.results[numIterations % NumMatrices][5]);
+}
+
+MCR_BENCHMARK(matrixInverse, "math/mat4.inverse", 0)
+{
+    auto& m = matrices();
+
+    for (uint64 i = 0; i < numIterations; ++i)
+    {
+        auto j = i % NumMatrices;
+        m.inputs[j].inverse(m.results[j]);
+    }
+
+    bench::keep(m.results[numIterations % NumMatrices][5]);
+}
+
+MCR_BENCHMARK(vectorNormalize, "math/vec3.normalize", 0)
+{
+    auto& m   = matrices();
+    vec3  sum;
+
+    for (uint64 i = 0; i < numIterations; ++i)
+        sum += math::normalize(m.vectors[i % NumMatrices]);
+
+    bench::keep(sum);
+}
+
+
+//////////////////////////////////////////////////////////////////////////
+// Batches, one iteration transforms a million points
+
+namespace {
+
+const std::size_t NumPoints = 1 << 20;
+
+struct Points
+{
+    std::vector<vec3> points, results;
+    ThreadPool pool;
+
+    Points(): points(NumPoints), results(NumPoints)
+    {
+        for (std::size_t i = 0; i < NumPoints; ++i)
+            points[i] = vec3(std::rand() / float(RAND_MAX), std::rand() / float(RAND_MAX), std::rand() / float(RAND_MAX));
+    }
+};
+
+Points& points()
+{
+    static Points s_points;
+    return s_points;
+}
+
+} // ns
+
+MCR_BENCHMARK(transformLoop, "math/transform_points.loop", 0)
+{
+    auto& p = points();
+    auto& m = matrices().inputs[0];
+
+    for (uint64 n = 0; n < numIterations; ++n)
+        for (std::size_t i = 0; i < NumPoints; ++i)
+            p.results[i] = p.points[i] * m + m.translation();
+
+    bench::keep(p.results[NumPoints / 2]);
+}
+
+MCR_BENCHMARK(transformBatch, "math/transform_points.batch", 0)
+{
+    auto& p = points();
+
+    for (uint64 n = 0; n < numIterations; ++n)
+        math::batch::transformPoints(&p.points[0], &p.results[0], NumPoints, matrices().inputs[0]);
+
+    bench::keep(p.results[NumPoints / 2]);
+}
+
+MCR_BENCHMARK(transformPool, "math/transform_points.pool", 0)
+{
+    auto& p = points();
+
+    for (uint64 n = 0; n < numIterations; ++n)
+        math::batch::transformPoints(&p.points[0], &p.results[0], NumPoints, matrices().inputs[0], &p.pool);
+
+    bench::keep(p.results[NumPoints / 2]);
+}
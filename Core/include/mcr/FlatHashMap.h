@@ -0,0 +1,219 @@
+#pragma once
+
+#include <functional>
+#include <utility>
+#include <vector>
+#include <mcr/Name.h>
+
+namespace mcr {
+
+template <typename K>
+struct FlatHash
+{
+    uint64 operator()(const K& key) const { return std::hash<K>()(key); }
+};
+
+template <>
+struct FlatHash<Name>
+{
+    uint64 operator()(Name key) const { return key.hash(); }
+};
+
+
+//! Open addressing hash map with linear probing, keeping everything in one
+//! array. Erased slots are tombstones until the next rehash, so erasing
+//! while iterating is safe. Keys and values must be default constructible.
+template <typename K, typename V, typename H = FlatHash<K>>
+class FlatHashMap
+{
+public:
+    typedef std::pair<K, V> value_type;
+
+    template <typename M, typename T>
+    class Iterator
+    {
+    public:
+        Iterator(M* map, std::size_t slot): m_map(map), m_slot(slot) { _skip(); }
+
+        T& operator*()  const { return m_map->m_slots[m_slot]; }
+        T* operator->() const { return &m_map->m_slots[m_slot]; }
+
+        Iterator& operator++()
+        {
+            ++m_slot;
+            _skip();
+            return *this;
+        }
+
+        bool operator==(const Iterator& rhs) const { return m_slot == rhs.m_slot; }
+        bool operator!=(const Iterator& rhs) const { return m_slot != rhs.m_slot; }
+
+    private:
+        friend class FlatHashMap;
+
+        void _skip()
+        {
+            while (m_slot < m_map->m_states.size() && m_map->m_states[m_slot] != Full)
+                ++m_slot;
+        }
+
+        M*          m_map;
+        std::size_t m_slot;
+    };
+
+    typedef Iterator<FlatHashMap, value_type> iterator;
+    typedef Iterator<const FlatHashMap, const value_type> const_iterator;
+
+    FlatHashMap(): m_size(0), m_numDeleted(0) {}
+
+    std::size_t     size() const    { return m_size; }
+    bool            empty() const   { return !m_size; }
+
+    iterator        begin()         { return iterator(this, 0); }
+    iterator        end()           { return iterator(this, m_states.size()); }
+    const_iterator  begin() const   { return const_iterator(this, 0); }
+    const_iterator  end() const     { return const_iterator(this, m_states.size()); }
+
+    iterator find(const K& key)
+    {
+        return iterator(this, _find(key));
+    }
+
+    const_iterator find(const K& key) const
+    {
+        return const_iterator(this, _find(key));
+    }
+
+    V& operator[](const K& key)
+    {
+        return insert(value_type(key, V())).first->second;
+    }
+
+    std::pair<iterator, bool> insert(const value_type& value)
+    {
+        auto slot = _find(value.first);
+        if (slot != m_states.size())
+            return std::make_pair(iterator(this, slot), false);
+
+        if ((m_size + m_numDeleted + 1) * 4 > m_states.size() * 3)
+            _rehash(m_size + 1);
+
+        auto mask = m_states.size() - 1;
+        slot = _mix(m_hasher(value.first)) & mask;
+
+        while (m_states[slot] == Full)
+            slot = (slot + 1) & mask;
+
+        if (m_states[slot] == Deleted)
+            --m_numDeleted;
+
+        m_states[slot] = Full;
+        m_slots[slot]  = value;
+        ++m_size;
+
+        return std::make_pair(iterator(this, slot), true);
+    }
+
+    //! The iterator to the next element
+    iterator erase(iterator it)
+    {
+        m_states[it.m_slot] = Deleted;
+        m_slots[it.m_slot]  = value_type();
+
+        --m_size;
+        ++m_numDeleted;
+
+        return ++it;
+    }
+
+    std::size_t erase(const K& key)
+    {
+        auto it = find(key);
+        if (it == end())
+            return 0;
+
+        erase(it);
+        return 1;
+    }
+
+    void clear()
+    {
+        m_slots.clear();
+        m_states.clear();
+        m_size = m_numDeleted = 0;
+    }
+
+    void reserve(std::size_t size)
+    {
+        if (size * 4 > m_states.size() * 3)
+            _rehash(size);
+    }
+
+private:
+    enum: byte {Empty, Full, Deleted};
+
+    static uint64 _mix(uint64 hash)
+    {
+        // Spread the high bits into the low ones the mask keeps
+        hash ^= hash >> 33;
+        hash *= 0xff51afd7ed558ccdull;
+        hash ^= hash >> 33;
+
+        return hash;
+    }
+
+    std::size_t _find(const K& key) const
+    {
+        if (!m_size)
+            return m_states.size();
+
+        auto mask = m_states.size() - 1;
+
+        for (auto slot = _mix(m_hasher(key)) & mask;; slot = (slot + 1) & mask)
+        {
+            if (m_states[slot] == Empty)
+                return m_states.size();
+
+            if (m_states[slot] == Full && m_slots[slot].first == key)
+                return slot;
+        }
+    }
+
+    void _rehash(std::size_t size)
+    {
+        std::size_t capacity = 8;
+
+        while (size * 4 > capacity * 3)
+            capacity *= 2;
+
+        std::vector<value_type> slots(capacity);
+        std::vector<byte>       states(capacity, Empty);
+
+        slots.swap(m_slots);
+        states.swap(m_states);
+
+        m_size = m_numDeleted = 0;
+
+        for (std::size_t i = 0; i < states.size(); ++i)
+        {
+            if (states[i] != Full)
+                continue;
+
+            auto slot = _mix(m_hasher(slots[i].first)) & (capacity - 1);
+
+            while (m_states[slot] == Full)
+                slot = (slot + 1) & (capacity - 1);
+
+            m_states[slot] = Full;
+            std::swap(m_slots[slot], slots[i]);
+            ++m_size;
+        }
+    }
+
+    std::vector<value_type> m_slots;
+    std::vector<byte>       m_states;
+    std::size_t             m_size, m_numDeleted;
+    H                       m_hasher;
+};
+
+} // ns mcr
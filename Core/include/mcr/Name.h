@@ -0,0 +1,55 @@
+#pragma once
+
+#include <string>
+#include <mcr/Types.h>
+
+namespace mcr {
+
+//! A string reduced to its 64-bit FNV-1a hash, so that lookups by name
+//! neither build nor compare strings. Literals are hashed at compile time
+//! when the compiler can; str() only knows interned names.
+class Name
+{
+public:
+    enum: uint64
+    {
+        Basis = 14695981039346656037ull,
+        Prime = 1099511628211ull
+    };
+
+    constexpr Name(): m_hash(Basis) {}
+    constexpr Name(const char* str): m_hash(_hash(str, Basis)) {}
+    Name(const std::string& str): m_hash(_hash(str.data(), str.size())) {}
+
+    //! Remember the string behind the name, for str()
+    MCR_CORE_EXTERN static Name intern(const char* str);
+
+    //! The interned string, empty if there's none
+    MCR_CORE_EXTERN const char* str() const;
+
+    constexpr uint64 hash() const { return m_hash; }
+
+private:
+    static constexpr uint64 _hash(const char* str, uint64 hash)
+    {
+        return *str ? _hash(str + 1, (hash ^ byte(*str)) * Prime) : hash;
+    }
+
+    static uint64 _hash(const char* str, std::size_t size)
+    {
+        uint64 hash = Basis;
+
+        for (std::size_t i = 0; i < size; ++i)
+            hash = (hash ^ byte(str[i])) * Prime;
+
+        return hash;
+    }
+
+    uint64 m_hash;
+};
+
+constexpr bool operator==(Name lhs, Name rhs) { return lhs.hash() == rhs.hash(); }
+constexpr bool operator!=(Name lhs, Name rhs) { return lhs.hash() != rhs.hash(); }
+constexpr bool operator< (Name lhs, Name rhs) { return lhs.hash() <  rhs.hash(); }
+
+} // ns mcr
@@ -0,0 +1,86 @@
+#pragma once
+
+#include <atomic>
+#include <mcr/Types.h>
+#include <mcr/NonCopyable.h>
+#include <mcr/io/IWriter.h>
+
+namespace mcr {
+
+//! Collects timed zones into rings, one per thread, so recording takes no
+//! locks; once a ring is full its oldest zones are overwritten. Recording is
+//! off until enabled, and then costs two clock reads per zone. Zone names
+//! aren't copied, so they must outlive the profiler (string literals do).
+class Profiler
+{
+public:
+    //! Zones kept per track
+    enum { TrackCapacity = 1 << 16 };
+
+    struct Track;
+
+    //! Nanoseconds on a steady clock, the time base of all zones
+    MCR_CORE_EXTERN static int64 now();
+
+    static bool                 isEnabled();
+    MCR_CORE_EXTERN static void setEnabled(bool enabled);
+
+    //! Record a finished zone on the calling thread's track
+    MCR_CORE_EXTERN static void record(const char* name, int64 start, int64 duration);
+
+    //! A track that isn't a thread, e.g. for GPU timings; it lives as long
+    //! as the program, and only one thread at a time may record on it
+    MCR_CORE_EXTERN static Track* track(const char* name);
+    MCR_CORE_EXTERN static void   record(Track* track, const char* name, int64 start, int64 duration);
+
+    //! Name the calling thread's track in exports
+    MCR_CORE_EXTERN static void setThreadName(const char* name);
+
+    //! Chrome trace_event JSON (chrome://tracing, Perfetto) of the zones
+    //! in the rings; best taken while nothing is recording
+    MCR_CORE_EXTERN static bool writeChromeTrace(io::IWriter* out);
+
+    //! Drop all recorded zones; only while no thread is recording, as the
+    //! rings are reset under their writers otherwise
+    MCR_CORE_EXTERN static void clear();
+
+private:
+    MCR_CORE_EXTERN static std::atomic<bool> s_enabled;
+};
+
+//! Records the zone from construction to destruction
+class ProfileScope: NonCopyable
+{
+public:
+    explicit ProfileScope(const char* name):
+        m_name(name),
+        m_start(Profiler::isEnabled() ? Profiler::now() : -1) {}
+
+    ~ProfileScope()
+    {
+        if (m_start >= 0)
+            Profiler::record(m_name, m_start, Profiler::now() - m_start);
+    }
+
+private:
+    const char* m_name;
+    int64       m_start;
+};
+
+
+inline bool Profiler::isEnabled()
+{
+    return s_enabled.load(std::memory_order_relaxed);
+}
+
+} // ns mcr
+
+#define MCR_PROFILE_CONCAT_(a, b) a##b
+#define MCR_PROFILE_CONCAT(a, b)  MCR_PROFILE_CONCAT_(a, b)
+
+//! Profile the rest of the enclosing scope as \c name; compiled out with MCR_NO_PROFILE
+#if defined(MCR_NO_PROFILE)
+#   define MCR_PROFILE_SCOPE(name)
+#else
+#   define MCR_PROFILE_SCOPE(name) ::mcr::ProfileScope MCR_PROFILE_CONCAT(mcrProfileScope, __LINE__)(name)
+#endif
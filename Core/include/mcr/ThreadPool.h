@@ -0,0 +1,48 @@
+#pragma once
+
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+#include <mcr/Types.h>
+#include <mcr/NonCopyable.h>
+
+namespace mcr {
+
+class ThreadPool: NonCopyable
+{
+public:
+    typedef std::function<void()> Task;
+
+    //! Spawn \c numThreads workers, or one less than the number of cores if zero
+    MCR_CORE_EXTERN explicit ThreadPool(uint numThreads = 0);
+    MCR_CORE_EXTERN ~ThreadPool(); // inherit not
+
+    uint                    numThreads() const;
+
+    //! Queue a task to be run on one of the workers
+    MCR_CORE_EXTERN void    enqueue(const Task& task);
+
+    //! Block until the queue is drained and all workers are idle
+    MCR_CORE_EXTERN void    wait();
+
+private:
+    MCR_CORE_INTERN void    _work();
+
+    std::vector<std::thread>    m_threads;
+    std::deque<Task>            m_tasks;
+    std::mutex                  m_mutex;
+    std::condition_variable     m_taskAdded, m_taskDone;
+    uint                        m_numBusy;
+    bool                        m_quit;
+};
+
+
+inline uint ThreadPool::numThreads() const
+{
+    return (uint) m_threads.size();
+}
+
+} // ns mcr
@@ -0,0 +1,105 @@
+#pragma once
+
+#include <memory>
+#include <string>
+#include <vector>
+#include <mcr/io/IFileReader.h>
+#include <mcr/io/IWriter.h>
+
+namespace mcr {
+namespace io  {
+
+//! Many files packed into one: a header, the file contents at aligned
+//! offsets (LZ4 compressed where that pays off), then a table of contents
+//! sorted by name hash and the names themselves.
+class Archive: public RefCounted
+{
+public:
+    using RefCounted::operator new;
+    using RefCounted::operator delete;
+
+    //! Read the table of contents of \c file, which is kept open; unless it
+    //! is memory-backed already, all of it is read into memory
+    MCR_CORE_EXTERN static rcptr<Archive> open(IFileReader* file);
+
+    uint                numEntries() const;
+    const char*         entryName(uint index) const;
+
+    bool                contains(const char* filename) const;
+
+    //! A reader for the entry, nullptr if there's none. Uncompressed entries
+    //! are read in place, without copying, and keep the archive's data alive
+    //! but not the archive; safe to call from several threads at once.
+    MCR_CORE_EXTERN rcptr<IFileReader> openReader(const char* filename);
+
+private:
+    struct Entry
+    {
+        uint64 hash;
+        uint64 offset, size, packedSize;
+        uint   nameOffset, flags;
+    };
+
+    Archive() {}
+
+    MCR_CORE_INTERN int _find(const char* filename) const;
+
+    // Atomically counted, readers come and go on loader threads
+    std::shared_ptr<rcptr<IFileReader>> m_file;
+    const byte*         m_data;
+    std::vector<Entry>  m_entries;
+    const char*         m_names;
+
+    friend class ArchiveBuilder;
+};
+
+//! Collects files in memory and writes them out as an Archive
+class ArchiveBuilder
+{
+public:
+    ArchiveBuilder(uint alignment = 16): m_alignment(alignment ? alignment : 1) {}
+
+    //! Add \c size bytes under \c filename; with \c compress, they are stored
+    //! compressed if that saves at least an eighth
+    MCR_CORE_EXTERN void add(const char* filename, const void* data, std::size_t size, bool compress = false);
+
+    std::size_t         numEntries() const;
+
+    MCR_CORE_EXTERN bool write(IWriter* out) const;
+
+private:
+    struct Item
+    {
+        std::string         name;
+        std::vector<byte>   data;
+        uint64              size;
+        bool                compressed;
+    };
+
+    uint                m_alignment;
+    std::vector<Item>   m_items;
+};
+
+
+inline uint Archive::numEntries() const
+{
+    return (uint) m_entries.size();
+}
+
+inline const char* Archive::entryName(uint index) const
+{
+    return m_names + m_entries[index].nameOffset;
+}
+
+inline bool Archive::contains(const char* filename) const
+{
+    return _find(filename) >= 0;
+}
+
+inline std::size_t ArchiveBuilder::numEntries() const
+{
+    return m_items.size();
+}
+
+} // ns io
+} // ns mcr
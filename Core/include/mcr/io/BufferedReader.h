@@ -0,0 +1,134 @@
+#pragma once
+
+#include <algorithm>
+#include <vector>
+#include <mcr/io/IReader.h>
+
+namespace mcr {
+namespace io  {
+
+//! Reads the underlying stream in large blocks, so that small reads and
+//! line scanning don't cost a virtual call and a stream call per byte
+class BufferedReader: public IReader
+{
+public:
+    using RefCounted::operator new;
+    using RefCounted::operator delete;
+    using IReader::read;
+
+    BufferedReader(IReader* reader, std::size_t blockSize = 64 * 1024):
+        m_reader(reader),
+        m_buffer(std::max<std::size_t>(blockSize, 16) + 1), // room for the final line's terminating zero
+        m_begin(0u),
+        m_end(0u),
+        m_eof(false) {}
+
+    std::size_t read(void* buffer, std::size_t size)
+    {
+        auto out = static_cast<char*>(buffer);
+        std::size_t total = 0;
+
+        while (total < size)
+        {
+            if (m_begin == m_end)
+            {
+                // Reads bigger than a block gain nothing from going through it
+                if (size - total >= _capacity())
+                    return total + m_reader->read(out + total, size - total);
+
+                if (!_fill())
+                    break;
+            }
+
+            auto bytes = std::min(size - total, m_end - m_begin);
+
+            std::memcpy(out + total, &m_buffer[m_begin], bytes);
+            m_begin += bytes;
+            total += bytes;
+        }
+
+        return total;
+    }
+
+    //! Next run of characters up to a '\\r' or '\\n', zero terminated in place
+    //! of the terminator. Points into the buffer, so it stays valid only until
+    //! the next read; \c false at the end of stream.
+    bool readLine(const char*& lineOut, std::size_t& lengthOut)
+    {
+        for (std::size_t scanned = 0;;)
+        {
+            auto begin = &m_buffer[m_begin] + scanned, end = &m_buffer[0] + m_end;
+            auto term  = static_cast<char*>(std::memchr(begin, '\n', end - begin));
+
+            if (auto cr = static_cast<char*>(std::memchr(begin, '\r', (term ? term : end) - begin)))
+                term = cr;
+
+            if (term)
+            {
+                *term = 0;
+
+                lineOut   = &m_buffer[m_begin];
+                lengthOut = term - lineOut;
+                m_begin  += lengthOut + 1;
+
+                return true;
+            }
+
+            scanned = m_end - m_begin;
+
+            if (!_fill())
+            {
+                if (m_begin == m_end)
+                    return false;
+
+                // Unterminated last line
+                m_buffer[m_end] = 0;
+
+                lineOut   = &m_buffer[m_begin];
+                lengthOut = m_end - m_begin;
+                m_begin   = m_end;
+
+                return true;
+            }
+        }
+    }
+
+private:
+    std::size_t _capacity() const
+    {
+        return m_buffer.size() - 1;
+    }
+
+    // Keep the unread part, moved to the front, and append as much as fits
+    bool _fill()
+    {
+        if (m_eof)
+            return false;
+
+        if (m_begin)
+        {
+            std::memmove(&m_buffer[0], &m_buffer[m_begin], m_end - m_begin);
+            m_end -= m_begin;
+            m_begin = 0;
+        }
+
+        // A line longer than the buffer
+        if (m_end == _capacity())
+            m_buffer.resize(2 * _capacity() + 1);
+
+        auto bytes = m_reader->read(&m_buffer[m_end], _capacity() - m_end);
+
+        m_end += bytes;
+        m_eof = !bytes;
+
+        return bytes != 0;
+    }
+
+    rcptr<IReader>      m_reader;
+    std::vector<char>   m_buffer;
+    std::size_t         m_begin, m_end;
+    bool                m_eof;
+};
+
+} // ns io
+} // ns mcr
@@ -1,8 +1,11 @@
 #pragma once
 
 #include <string>
+#include <utility>
+#include <vector>
 #include <mcr/CoreExtern.h>
 #include <mcr/NonCopyable.h>
+#include <mcr/io/Archive.h>
 #include <mcr/io/IFileReader.h>
 #include <mcr/io/IFileWriter.h>
 
@@ -41,11 +44,22 @@ public:
     const std::string&      root() const;
     MCR_CORE_EXTERN bool    setRoot(const char* dir, std::string* oldRootOut = nullptr);
 
+    //! Mount the archive \c filename (relative to the root); its entries are
+    //! preferred to loose files with \c overRoot, and fall back otherwise.
+    //! Archives mounted later are searched first.
+    MCR_CORE_EXTERN bool    mount(const char* filename, bool overRoot = true);
+    MCR_CORE_EXTERN void    unmountAll();
+
     MCR_CORE_EXTERN rcptr<IFileReader>  openReader(const char* filename, bool binary = true);
     MCR_CORE_EXTERN rcptr<IFileWriter>  openWriter(const char* filename, bool binary = true);
 
 private:
-    std::string m_root;
+    typedef std::pair<rcptr<Archive>, bool> Mount;
+
+    MCR_CORE_INTERN rcptr<IFileReader>  _openFromArchives(const char* filename, bool overRoot);
+
+    std::string         m_root;
+    std::vector<Mount>  m_mounts;
 };
 
 } // ns io
@@ -12,6 +12,9 @@ public:
     virtual uint64      tell() const     = 0;
     virtual void        seek(uint64 pos) = 0;
     virtual const char* filename() const = 0;
+
+    //! Whole file contents if the reader is memory-backed, \c nullptr otherwise
+    virtual const void* data() const     = 0;
 };
 
 } // ns io
@@ -1,6 +1,6 @@
 #pragma once
 
-#include <mcr/io/IReader.h>
+#include <mcr/io/BufferedReader.h>
 
 namespace mcr {
 namespace io  {
@@ -8,18 +8,22 @@ namespace io  {
 class LineParser
 {
 public:
-    LineParser(IReader* reader): m_reader(reader) {}
+    LineParser(IReader* reader): m_reader(new BufferedReader(reader)), m_line(""), m_length(0), m_indent(0) {}
+    LineParser(BufferedReader* reader): m_reader(reader), m_line(""), m_length(0), m_indent(0) {}
     ~LineParser() {} // inherit not
 
     bool                readLine();
 
-    const std::string&  line() const;
+    //! The current line without its indentation; valid until the next readLine()
+    const char*         line() const;
+    std::size_t         length() const;
     std::size_t         indent() const;
 
 private:
-    rcptr<IReader>  m_reader;
+    rcptr<BufferedReader> m_reader;
 
-    std::string     m_line;
+    const char*     m_line;
+    std::size_t     m_length;
     std::size_t     m_indent;
 };
 
@@ -27,31 +31,41 @@ private:
 inline bool LineParser::readLine()
 {
     // skip empty lines (including the fake ones between terminators)
-    for (m_line.clear(); m_line.empty();)
+    for (m_length = 0; !m_length;)
     {
-        if (!m_reader->readString(m_line, "\r\n"))
+        if (!m_reader->readLine(m_line, m_length))
         {
+            m_line   = "";
+            m_length = 0;
             m_indent = 0;
             return false;
         }
     }
 
-    auto firstNonSpace = m_line.find_first_not_of(" \xA0\t");
+    for (m_indent = 0; m_indent < m_length; ++m_indent)
+    {
+        auto chr = m_line[m_indent];
 
-    m_indent = firstNonSpace != std::string::npos
-             ? firstNonSpace
-             : m_line.size();
+        if (chr != ' ' && chr != '\t' && chr != '\xA0')
+            break;
+    }
 
-    m_line = m_line.substr(m_indent);
+    m_line   += m_indent;
+    m_length -= m_indent;
 
     return true;
 }
 
-inline const std::string& LineParser::line() const
+inline const char* LineParser::line() const
 {
     return m_line;
 }
 
+inline std::size_t LineParser::length() const
+{
+    return m_length;
+}
+
 inline std::size_t LineParser::indent() const
 {
     return m_indent;
@@ -0,0 +1,24 @@
+#pragma once
+
+#include <mcr/Types.h>
+
+namespace mcr {
+namespace io  {
+
+//! LZ4 block format, without the frame around it
+class Lz4
+{
+public:
+    //! Worst case size of \c size bytes compressed
+    static std::size_t bound(std::size_t size) { return size + size / 255 + 16; }
+
+    //! Compress \c size bytes of \c src into \c dst, which must hold bound(size)
+    //! bytes; returns the compressed size
+    MCR_CORE_EXTERN static std::size_t compress(const void* src, std::size_t size, void* dst);
+
+    //! Decompress into exactly \c dstSize bytes; false if \c src is malformed
+    MCR_CORE_EXTERN static bool decompress(const void* src, std::size_t size, void* dst, std::size_t dstSize);
+};
+
+} // ns io
+} // ns mcr
@@ -0,0 +1,94 @@
+#pragma once
+
+#include <algorithm>
+#include <vector>
+#include <mcr/io/IFileReader.h>
+
+namespace mcr {
+namespace io  {
+
+class MemoryReader: public IFileReader
+{
+public:
+    using RefCounted::operator new;
+    using RefCounted::operator delete;
+
+    //! Wrap \c buffer, taking its contents over
+    MemoryReader(const char* filename, std::vector<byte>& buffer):
+        m_filename(filename),
+        m_pos(0u)
+    {
+        m_buffer.swap(buffer);
+
+        m_data = m_buffer.empty() ? nullptr : &m_buffer[0];
+        m_size = m_buffer.size();
+    }
+
+    //! Wrap external memory; \c owner, if any, is kept alive as long as the reader
+    MemoryReader(const char* filename, const void* data, std::size_t size, RefCounted* owner = nullptr):
+        m_filename(filename),
+        m_owner(owner),
+        m_data(static_cast<const byte*>(data)),
+        m_size(size),
+        m_pos(0u) {}
+
+    //! Read the remainder of \c file into memory, unless it's there already
+    static rcptr<IFileReader> fromFile(IFileReader* file)
+    {
+        if (!file || file->data())
+            return file;
+
+        std::vector<byte> buffer((std::size_t) (file->size() - file->tell()));
+
+        if (!buffer.empty())
+            buffer.resize(file->read(&buffer[0], buffer.size()));
+
+        return new MemoryReader(file->filename(), buffer);
+    }
+
+    std::size_t read(void* buffer, std::size_t size)
+    {
+        auto bytes = std::min(size, m_size - m_pos);
+
+        std::memcpy(buffer, m_data + m_pos, bytes);
+        m_pos += bytes;
+
+        return bytes;
+    }
+
+    uint64 size() const
+    {
+        return m_size;
+    }
+
+    uint64 tell() const
+    {
+        return m_pos;
+    }
+
+    void seek(uint64 pos)
+    {
+        m_pos = (std::size_t) std::min<uint64>(pos, m_size);
+    }
+
+    const char* filename() const
+    {
+        return m_filename.c_str();
+    }
+
+    const void* data() const
+    {
+        return m_data;
+    }
+
+private:
+    std::string         m_filename;
+    std::vector<byte>   m_buffer;
+    rcptr<RefCounted>   m_owner;
+
+    const byte*         m_data;
+    std::size_t         m_size, m_pos;
+};
+
+} // ns io
+} // ns mcr
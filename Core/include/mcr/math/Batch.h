@@ -0,0 +1,45 @@
+#pragma once
+
+#include <mcr/Types.h>
+#include <mcr/math/Matrix.h>
+
+namespace mcr {
+
+class ThreadPool;
+
+namespace math  {
+namespace batch {
+
+// Kernels over whole arrays, vectorized where the math is.
+//
+// Vectors come either packed as vec3 (AoS) or as separate x, y, z
+// arrays (SoA). Outputs may alias the inputs element for element.
+// With a pool given, large arrays are split among its workers and
+// the calling thread, which returns once all parts are done.
+
+//! out[i] = in[i] * m, translation left out like vec3 * mat4
+MCR_CORE_EXTERN void transformVectors(const vec3* in, vec3* out, std::size_t n,
+                                      const mat4& m, ThreadPool* pool = nullptr);
+
+//! out[i] = in[i] * m + m.translation()
+MCR_CORE_EXTERN void transformPoints(const vec3* in, vec3* out, std::size_t n,
+                                     const mat4& m, ThreadPool* pool = nullptr);
+
+MCR_CORE_EXTERN void transformPoints(const float* x, const float* y, const float* z,
+                                     float* outX, float* outY, float* outZ, std::size_t n,
+                                     const mat4& m, ThreadPool* pool = nullptr);
+
+//! out[i] = lhs * rhs[i], e.g. a view-projection times each model matrix
+MCR_CORE_EXTERN void multiply(const mat4& lhs, const mat4* rhs, mat4* out, std::size_t n,
+                              ThreadPool* pool = nullptr);
+
+//! Same as math::normalize for each; near zero vectors are left as they are
+MCR_CORE_EXTERN void normalize(const vec3* in, vec3* out, std::size_t n, ThreadPool* pool = nullptr);
+
+MCR_CORE_EXTERN void normalize(const float* x, const float* y, const float* z,
+                               float* outX, float* outY, float* outZ, std::size_t n,
+                               ThreadPool* pool = nullptr);
+
+} // ns batch
+} // ns math
+} // ns mcr
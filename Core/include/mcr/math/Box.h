@@ -0,0 +1,101 @@
+#pragma once
+
+#include <mcr/math/Matrix.h>
+
+namespace mcr  {
+namespace math {
+
+//! Axis-aligned box; a default constructed one is empty and grows with add()
+template <typename T>
+class Box
+{
+public:
+    Box<T>():
+        m_min( std::numeric_limits<T>::max()),
+        m_max(std::numeric_limits<T>::lowest()) {}
+
+    Box<T>(const Vector<T, 3>& min, const Vector<T, 3>& max):
+        m_min(min), m_max(max) {}
+
+    static Box<T> byCenter(const Vector<T, 3>& center, const Vector<T, 3>& extent)
+    {
+        return Box<T>(center - extent, center + extent);
+    }
+
+
+    const Vector<T, 3>& min() const { return m_min; }
+    const Vector<T, 3>& max() const { return m_max; }
+
+    bool isEmpty() const
+    {
+        return m_min.x() > m_max.x() || m_min.y() > m_max.y() || m_min.z() > m_max.z();
+    }
+
+    Vector<T, 3> center() const { return (m_min + m_max) / T(2); }
+    Vector<T, 3> extent() const { return (m_max - m_min) / T(2); }
+    Vector<T, 3> size()   const { return m_max - m_min; }
+
+
+    Box<T>& add(const Vector<T, 3>& point)
+    {
+        m_min.set(std::min(m_min.x(), point.x()), std::min(m_min.y(), point.y()), std::min(m_min.z(), point.z()));
+        m_max.set(std::max(m_max.x(), point.x()), std::max(m_max.y(), point.y()), std::max(m_max.z(), point.z()));
+
+        return *this;
+    }
+
+    Box<T>& add(const Box<T>& box)
+    {
+        if (!box.isEmpty())
+            add(box.min()).add(box.max());
+
+        return *this;
+    }
+
+    bool contains(const Vector<T, 3>& point) const
+    {
+        return m_min.x() <= point.x() && point.x() <= m_max.x()
+            && m_min.y() <= point.y() && point.y() <= m_max.y()
+            && m_min.z() <= point.z() && point.z() <= m_max.z();
+    }
+
+protected:
+    Vector<T, 3> m_min, m_max;
+};
+
+//! The box bounding \c box once transformed by \c m
+template <typename T>
+inline Box<T> transform(const Box<T>& box, const Matrix4x4<T>& m)
+{
+    if (box.isEmpty())
+        return box;
+
+    auto extent = box.extent();
+
+    Vector<T, 3> newExtent(
+        extent.x() * std::abs(m[0]) + extent.y() * std::abs(m[4]) + extent.z() * std::abs(m[ 8]),
+        extent.x() * std::abs(m[1]) + extent.y() * std::abs(m[5]) + extent.z() * std::abs(m[ 9]),
+        extent.x() * std::abs(m[2]) + extent.y() * std::abs(m[6]) + extent.z() * std::abs(m[10]));
+
+    return Box<T>::byCenter(box.center() * m + m.translation(), newExtent);
+}
+
+template <typename T>
+inline bool operator==(const Box<T>& lhs, const Box<T>& rhs)
+{
+    return lhs.min() == rhs.min() && lhs.max() == rhs.max();
+}
+
+template <typename T>
+inline bool operator!=(const Box<T>& lhs, const Box<T>& rhs)
+{
+    return !(lhs == rhs);
+}
+
+} // ns math
+
+typedef math::Box<float> bbox;
+typedef math::Box<double> dbbox;
+typedef math::Box<uint> ubbox;
+
+} // ns mcr
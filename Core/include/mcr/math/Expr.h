@@ -1,56 +1,311 @@
 #pragma once
 
 #include <functional>
+#include <type_traits>
+#include <mcr/Types.h>
 
 namespace mcr  {
 namespace math {
 
-struct Expr
+// Layout expressions of a limit (the length being laid out), e.g.
+// percents(50) - 10. Operators build plain expression templates that
+// inline and, given constant inputs, evaluate at compile time; Expr is
+// where they are stored. It flattens them into a short op list, folding
+// whatever is linear in the limit (the usual case) into a single
+// scale * limit + offset.
+
+//! scale * limit + offset
+struct AffineExpr
+{
+    float scale, offset;
+
+    constexpr AffineExpr(float units):
+        scale(0), offset(units) {}
+
+    constexpr AffineExpr(float ascale, float aoffset):
+        scale(ascale), offset(aoffset) {}
+
+    constexpr float operator()(float limit) const
+    {
+        return scale * limit + offset;
+    }
+};
+
+struct ExprOp
+{
+    enum Code {Push, Add, Sub, Mul, Div};
+};
+
+template <typename L, typename R, int op>
+struct BinaryExpr
+{
+    L left;
+    R right;
+
+    constexpr BinaryExpr(const L& aleft, const R& aright):
+        left(aleft), right(aright) {}
+
+    constexpr float operator()(float limit) const
+    {
+        return op == ExprOp::Add ? left(limit) + right(limit)
+             : op == ExprOp::Sub ? left(limit) - right(limit)
+             : op == ExprOp::Mul ? left(limit) * right(limit)
+             :                     left(limit) / right(limit);
+    }
+};
+
+class Expr;
+
+template <typename T> struct IsExpr: std::false_type {};
+
+template <> struct IsExpr<AffineExpr>: std::true_type {};
+template <> struct IsExpr<Expr>:       std::true_type {};
+
+template <typename L, typename R, int op>
+struct IsExpr<BinaryExpr<L, R, op>>: std::true_type {};
+
+
+//! Stores any expression without allocating, unless it is too long to
+//! flatten or is an arbitrary function; a default constructed one is empty
+class Expr
 {
-    Expr(const std::function<float(float)>& eval):
-        evaluate(eval) {}
+public:
+    enum { MaxOps = 16 };
+
+    Expr():
+        m_ops(), m_numOps(0) {}
 
     Expr(float units):
-        evaluate([units] (float) { return units; }) {}
+        m_ops(), m_numOps(0)
+    {
+        _push(units);
+    }
+
+    template <typename E>
+    Expr(const E& expr, typename std::enable_if<IsExpr<E>::value>::type* = nullptr):
+        m_ops(), m_numOps(0)
+    {
+        if (!_compile(expr))
+        {
+            m_numOps = 0;
+            m_custom = expr;
+        }
+    }
+
+    //! The slow path, for anything the operators can't express
+    Expr(const std::function<float(float)>& fn):
+        m_ops(), m_numOps(0), m_custom(fn) {}
+
+    bool isEmpty() const
+    {
+        return !m_numOps && !m_custom;
+    }
+
+    //! Whether evaluation comes down to scale * limit + offset
+    bool isAffine() const
+    {
+        return m_numOps == 1;
+    }
+
+    //! Meaningful if isAffine(); zero for an empty expression
+    AffineExpr affine() const
+    {
+        return m_numOps == 1 ? AffineExpr(m_ops[0].scale, m_ops[0].offset) : AffineExpr(0);
+    }
+
+    float evaluate(float limit) const
+    {
+        if (m_numOps == 1)
+            return m_ops[0].scale * limit + m_ops[0].offset;
+
+        if (!m_numOps)
+            return m_custom ? m_custom(limit) : 0.f;
+
+        return _run(limit);
+    }
+
+    float operator()(float limit) const
+    {
+        return evaluate(limit);
+    }
+
+private:
+    struct Op
+    {
+        byte  code;
+        float scale, offset;
+    };
+
+    bool _push(const AffineExpr& affine)
+    {
+        if (m_numOps == MaxOps)
+            return false;
 
-    std::function<float(float)> evaluate;
+        Op op = {ExprOp::Push, affine.scale, affine.offset};
+        m_ops[m_numOps++] = op;
+
+        return true;
+    }
+
+    bool _binary(int code)
+    {
+        if (m_numOps >= 2)
+        {
+            auto& a = m_ops[m_numOps - 2];
+            auto& b = m_ops[m_numOps - 1];
+
+            if (a.code == ExprOp::Push && b.code == ExprOp::Push && _fold(code, a, b))
+            {
+                --m_numOps;
+                return true;
+            }
+        }
+
+        if (m_numOps == MaxOps)
+            return false;
+
+        Op op = {(byte) code, 0, 0};
+        m_ops[m_numOps++] = op;
+
+        return true;
+    }
+
+    // Combine two pushes into one if the result stays linear in the limit
+    static bool _fold(int code, Op& a, const Op& b)
+    {
+        switch (code)
+        {
+        case ExprOp::Add:
+            a.scale += b.scale;
+            a.offset += b.offset;
+            return true;
+
+        case ExprOp::Sub:
+            a.scale -= b.scale;
+            a.offset -= b.offset;
+            return true;
+
+        case ExprOp::Mul:
+            if (a.scale != 0 && b.scale != 0)
+                return false;
+
+            a.scale = a.scale * b.offset + b.scale * a.offset;
+            a.offset *= b.offset;
+            return true;
+
+        case ExprOp::Div:
+            if (b.scale != 0)
+                return false;
+
+            a.scale /= b.offset;
+            a.offset /= b.offset;
+            return true;
+        }
+
+        return false;
+    }
+
+    bool _compile(const AffineExpr& expr)
+    {
+        return _push(expr);
+    }
+
+    bool _compile(const Expr& expr)
+    {
+        if (!expr.m_numOps)
+            return expr.isEmpty() ? _push(AffineExpr(0)) : false;
+
+        for (byte i = 0; i < expr.m_numOps; ++i)
+        {
+            auto& op = expr.m_ops[i];
+
+            if (!(op.code == ExprOp::Push ? _push(AffineExpr(op.scale, op.offset)) : _binary(op.code)))
+                return false;
+        }
+
+        return true;
+    }
+
+    template <typename L, typename R, int op>
+    bool _compile(const BinaryExpr<L, R, op>& expr)
+    {
+        return _compile(expr.left) && _compile(expr.right) && _binary(op);
+    }
+
+    float _run(float limit) const
+    {
+        float stack[MaxOps];
+        int top = 0;
+
+        for (byte i = 0; i < m_numOps; ++i)
+        {
+            auto& op = m_ops[i];
+
+            switch (op.code)
+            {
+            case ExprOp::Push: stack[top++] = op.scale * limit + op.offset; break;
+            case ExprOp::Add:  --top; stack[top - 1] += stack[top]; break;
+            case ExprOp::Sub:  --top; stack[top - 1] -= stack[top]; break;
+            case ExprOp::Mul:  --top; stack[top - 1] *= stack[top]; break;
+            case ExprOp::Div:  --top; stack[top - 1] /= stack[top]; break;
+            }
+        }
+
+        return stack[0];
+    }
+
+    Op                          m_ops[MaxOps];
+    byte                        m_numOps;
+    std::function<float(float)> m_custom;
 };
 
-inline Expr percents(float amount)
+
+constexpr AffineExpr percents(float amount)
 {
-    return Expr([amount] (float limit) { return .01f * amount * limit; });
+    return AffineExpr(.01f * amount, 0);
 }
 
-inline Expr operator+(const Expr& left, const Expr& right)
+//! The limit itself
+constexpr AffineExpr limit()
 {
-    return Expr([left, right] (float limit)
-    {
-        return left.evaluate(limit) + right.evaluate(limit);
-    });
+    return AffineExpr(1, 0);
 }
 
-inline Expr operator-(const Expr& left, const Expr& right)
+
+template <typename T>
+struct ExprOperand
 {
-    return Expr([left, right] (float limit)
-    {
-        return left.evaluate(limit) - right.evaluate(limit);
-    });
+    typedef typename std::conditional<IsExpr<T>::value, T, AffineExpr>::type type;
+};
+
+template <typename L, typename R, int op>
+struct ExprResult: std::enable_if<
+    (IsExpr<L>::value && (IsExpr<R>::value || std::is_arithmetic<R>::value)) ||
+    (IsExpr<R>::value && std::is_arithmetic<L>::value),
+    BinaryExpr<typename ExprOperand<L>::type, typename ExprOperand<R>::type, op>> {};
+
+template <typename L, typename R>
+constexpr typename ExprResult<L, R, ExprOp::Add>::type operator+(const L& left, const R& right)
+{
+    return typename ExprResult<L, R, ExprOp::Add>::type(left, right);
 }
 
-inline Expr operator*(const Expr& left, const Expr& right)
+template <typename L, typename R>
+constexpr typename ExprResult<L, R, ExprOp::Sub>::type operator-(const L& left, const R& right)
 {
-    return Expr([left, right] (float limit)
-    {
-        return left.evaluate(limit) * right.evaluate(limit);
-    });
+    return typename ExprResult<L, R, ExprOp::Sub>::type(left, right);
 }
 
-inline Expr operator/(const Expr& left, const Expr& right)
+template <typename L, typename R>
+constexpr typename ExprResult<L, R, ExprOp::Mul>::type operator*(const L& left, const R& right)
 {
-    return Expr([left, right] (float limit)
-    {
-        return left.evaluate(limit) / right.evaluate(limit);
-    });
+    return typename ExprResult<L, R, ExprOp::Mul>::type(left, right);
+}
+
+template <typename L, typename R>
+constexpr typename ExprResult<L, R, ExprOp::Div>::type operator/(const L& left, const R& right)
+{
+    return typename ExprResult<L, R, ExprOp::Div>::type(left, right);
 }
 
 } // ns math
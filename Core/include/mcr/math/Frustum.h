@@ -0,0 +1,96 @@
+#pragma once
+
+#include <mcr/math/Sphere.h>
+
+namespace mcr  {
+namespace math {
+
+//! Six inward facing planes (a, b, c, d), a point p being inside
+//! a plane when dot(p, abc) + d >= 0
+template <typename T>
+class Frustum
+{
+public:
+    enum Plane {Left, Right, Bottom, Top, Near, Far, NumPlanes};
+
+    Frustum<T>() {}
+
+    //! Planes of the clip volume of \c viewProj, in the space it transforms from
+    explicit Frustum<T>(const Matrix4x4<T>& viewProj)
+    {
+        set(viewProj);
+    }
+
+    void set(const Matrix4x4<T>& m)
+    {
+        // Vectors are rows, so clip coordinates are dot products with the columns
+        Vector<T, 4>
+            x(m[0], m[4], m[ 8], m[12]),
+            y(m[1], m[5], m[ 9], m[13]),
+            z(m[2], m[6], m[10], m[14]),
+            w(m[3], m[7], m[11], m[15]);
+
+        m_planes[Left]   = normalizePlane(w + x);
+        m_planes[Right]  = normalizePlane(w - x);
+        m_planes[Bottom] = normalizePlane(w + y);
+        m_planes[Top]    = normalizePlane(w - y);
+        m_planes[Near]   = normalizePlane(w + z);
+        m_planes[Far]    = normalizePlane(w - z);
+    }
+
+    const Vector<T, 4>& plane(int i) const { return m_planes[i]; }
+
+
+    T distance(int plane, const Vector<T, 3>& point) const
+    {
+        auto& p = m_planes[plane];
+        return p.x() * point.x() + p.y() * point.y() + p.z() * point.z() + p.w();
+    }
+
+    bool intersects(const Sphere<T>& sphere) const
+    {
+        for (int i = 0; i < NumPlanes; ++i)
+            if (distance(i, sphere.center()) < -sphere.radius())
+                return false;
+
+        return true;
+    }
+
+    //! Conservative: a box near a corner of the frustum may pass while outside.
+    //! An empty box stands for unknown bounds, as with meshes, and passes.
+    bool intersects(const Box<T>& box) const
+    {
+        if (box.isEmpty())
+            return true;
+
+        auto center = box.center();
+        auto extent = box.extent();
+
+        for (int i = 0; i < NumPlanes; ++i)
+        {
+            auto& p = m_planes[i];
+            T radius = extent.x() * std::abs(p.x()) + extent.y() * std::abs(p.y()) + extent.z() * std::abs(p.z());
+
+            if (distance(i, center) < -radius)
+                return false;
+        }
+
+        return true;
+    }
+
+protected:
+    static Vector<T, 4> normalizePlane(const Vector<T, 4>& p)
+    {
+        T len = std::sqrt(p.x() * p.x() + p.y() * p.y() + p.z() * p.z());
+        return len > T(0) ? p / len : p;
+    }
+
+    Vector<T, 4> m_planes[NumPlanes];
+};
+
+} // ns math
+
+typedef math::Frustum<float> frustum;
+typedef math::Frustum<double> dfrustum;
+
+} // ns mcr
@@ -1,51 +1,67 @@
 #pragma once
 
 #include <vector>
+#include <algorithm>
 #include <mcr/math/Rect.h>
+#include <mcr/math/Box.h>
 #include <mcr/math/Expr.h>
 
 namespace mcr  {
 namespace math {
 
+//! Axes along one dimension, each placed by an expression of the range's
+//! length. Changes only mark the affected axes dirty; offsets are
+//! evaluated on the next query, all in one pass when the range changed.
 class GridDimension
 {
 public:
-    struct AxisInfo
-    {
-        AxisInfo(float aoffset, const Expr& aexpr = Expr(nullptr)):
-            offset(aoffset), expr(aexpr) {}
-
-        float offset;
-        Expr expr;
-    };
+    GridDimension():
+        m_allDirty(false), m_sortDirty(false) {}
 
     void insertAxis(uint index, const Expr& expr)
     {
-        if (m_axes.size() <= index)
-            m_axes.resize(index + 1, AxisInfo(m_range[0]));
-
-        m_axes[index] = AxisInfo(m_range[0], expr);
-
-        if (expr.evaluate)
-            m_axes[index].offset += expr.evaluate(m_range[1] - m_range[0]);
+        if (m_exprs.size() <= index)
+        {
+            m_exprs.resize(index + 1);
+            m_scales.resize(index + 1, 0.f);
+            m_biases.resize(index + 1, 0.f);
+            m_offsets.resize(index + 1, m_range[0]);
+        }
+
+        _setExpr(index, expr);
     }
 
     void removeAxis(uint axis)
     {
-        m_axes[axis] = AxisInfo(m_range[0]);
+        _setExpr(axis, Expr());
+
+        while (!m_exprs.empty() && m_exprs.back().isEmpty())
+        {
+            m_exprs.pop_back();
+            m_scales.pop_back();
+            m_biases.pop_back();
+            m_offsets.pop_back();
+        }
 
-        while (!m_axes.back().expr.evaluate)
-            m_axes.pop_back(); 
+        m_sortDirty = true;
     }
 
     uint numAxes() const
     {
-        return (uint) m_axes.size();
+        return (uint) m_exprs.size();
     }
 
     float axis(uint axis) const
     {
-        return m_axes[axis].offset;
+        _update();
+        return m_offsets[axis];
+    }
+
+    //! All axis offsets, by index
+    const std::vector<float>& axes() const
+    {
+        _update();
+        return m_offsets;
     }
 
     vec2 interval(const uvec2& axes) const
@@ -53,34 +69,119 @@ public:
         return vec2(axis(axes.x()), axis(axes.y()));
     }
 
+    //! The pair of neighboring axes around \c pos, by binary search over
+    //! the set axes ordered by offset; false if \c pos lies outside all of
+    //! them. On an axis, it's the cell after it, after the last of axes
+    //! sharing an offset.
+    bool cellAt(float pos, uvec2& axesOut) const
+    {
+        _update();
+
+        if (m_sortDirty)
+            _sort();
+
+        auto less = [this] (float pos, uint axis) { return pos < m_offsets[axis]; };
+        auto it   = std::upper_bound(m_sorted.begin(), m_sorted.end(), pos, less);
+
+        if (it == m_sorted.begin() || it == m_sorted.end())
+            return false;
+
+        axesOut.set(*(it - 1), *it);
+        return true;
+    }
+
     const vec2& range() const
     {
         return m_range;
     }
+
     void setRange(const vec2& range)
     {
         m_range = range;
+        m_allDirty = true;
+    }
 
-        float len = range[1] - range[0];
+protected:
+    void _setExpr(uint index, const Expr& expr)
+    {
+        auto affine = expr.affine();
 
-        for (uint i = 0; i < m_axes.size(); ++i)
-            if (m_axes[i].expr.evaluate)
-                m_axes[i].offset = range[0] + m_axes[i].expr.evaluate(len);
-            else
-                m_axes[i].offset = range[0];
+        m_exprs [index] = expr;
+        m_scales[index] = affine.scale;
+        m_biases[index] = affine.offset;
+
+        if (!m_allDirty)
+            m_dirty.push_back(index);
     }
 
-protected:
-    std::vector<AxisInfo> m_axes;
+    float _evaluate(uint i, float length) const
+    {
+        return m_exprs[i].isAffine() || m_exprs[i].isEmpty()
+            ? m_range[0] + m_scales[i] * length + m_biases[i]
+            : m_range[0] + m_exprs[i].evaluate(length);
+    }
+
+    void _update() const
+    {
+        float length = m_range[1] - m_range[0];
+
+        if (m_allDirty)
+        {
+            // The affine bulk of the axes is a straight loop over the coefficients
+            for (std::size_t i = 0; i < m_offsets.size(); ++i)
+                m_offsets[i] = m_range[0] + m_scales[i] * length + m_biases[i];
+
+            for (std::size_t i = 0; i < m_exprs.size(); ++i)
+                if (!m_exprs[i].isAffine() && !m_exprs[i].isEmpty())
+                    m_offsets[i] = m_range[0] + m_exprs[i].evaluate(length);
+
+            m_allDirty = false;
+            m_sortDirty = true;
+            m_dirty.clear();
+        }
+        else if (!m_dirty.empty())
+        {
+            for (auto it = m_dirty.begin(); it != m_dirty.end(); ++it)
+                if (*it < m_offsets.size())
+                    m_offsets[*it] = _evaluate(*it, length);
+
+            m_sortDirty = true;
+            m_dirty.clear();
+        }
+    }
+
+    // Unset axes are left out, they bound no cells
+    void _sort() const
+    {
+        m_sorted.clear();
+
+        for (uint i = 0; i < m_offsets.size(); ++i)
+            if (!m_exprs[i].isEmpty())
+                m_sorted.push_back(i);
+
+        std::stable_sort(m_sorted.begin(), m_sorted.end(),
+            [this] (uint a, uint b) { return m_offsets[a] < m_offsets[b]; });
+
+        m_sortDirty = false;
+    }
+
+    std::vector<Expr>           m_exprs;
+    std::vector<float>          m_scales, m_biases; // of the affine expressions, zero for others
+
+    mutable std::vector<float>  m_offsets;
+    mutable std::vector<uint>   m_dirty;
+    mutable std::vector<uint>   m_sorted;           // axis indices by offset
+    mutable bool                m_allDirty, m_sortDirty;
+
     vec2 m_range;
 };
 
 
 template <int Dim> struct GridTraits {};
 
-template <> struct GridTraits<1> { typedef vec2 Range; typedef uvec2 Interval; };
-template <> struct GridTraits<2> { typedef rect Range; typedef urect Interval; };
-//template <> struct GridTraits<3> { typedef bbox Range; typedef ubbox Interval; };
+template <> struct GridTraits<1> { typedef vec2 Range; typedef uvec2 Interval; typedef float Point; };
+template <> struct GridTraits<2> { typedef rect Range; typedef urect Interval; typedef vec2  Point; };
+template <> struct GridTraits<3> { typedef bbox Range; typedef ubbox Interval; typedef vec3  Point; };
 
 
 template <int Dim, typename Traits = GridTraits<Dim>>
@@ -89,12 +190,16 @@ class Grid
 public:
     typedef typename Traits::Range Range;
     typedef typename Traits::Interval Interval;
+    typedef typename Traits::Point Point;
 
     Range interval(const Interval& axes) const;
 
     Range range() const;
     void setRange(const Range& range);
 
+    //! Axes bounding the cell that contains \c point, false if none does
+    bool cellAt(const Point& point, Interval& axesOut) const;
+
     Range operator()(const Interval& axes) const { return interval(axes); }
 
     const GridDimension& operator[](int i) const { return m_dim[i]; }
@@ -104,6 +209,38 @@ protected:
     GridDimension m_dim[Dim];
 };
 
+
+//////////////////////////////////////////////////////////////////////////
+// Grid<1>
+
+template <>
+inline Grid<1>::Range Grid<1>::interval(const Interval& axes) const
+{
+    return m_dim[0].interval(axes);
+}
+
+template <>
+inline Grid<1>::Range Grid<1>::range() const
+{
+    return m_dim[0].range();
+}
+
+template <>
+inline void Grid<1>::setRange(const Range& range)
+{
+    m_dim[0].setRange(range);
+}
+
+template <>
+inline bool Grid<1>::cellAt(const Point& point, Interval& axesOut) const
+{
+    return m_dim[0].cellAt(point, axesOut);
+}
+
+
+//////////////////////////////////////////////////////////////////////////
+// Grid<2>
+
 template <>
 inline Grid<2>::Range Grid<2>::interval(const Interval& axes) const
 {
@@ -128,9 +265,64 @@ inline void Grid<2>::setRange(const Range& range)
     m_dim[1].setRange(vec2(range[0][1], range[1][1]));
 }
 
+template <>
+inline bool Grid<2>::cellAt(const Point& point, Interval& axesOut) const
+{
+    uvec2 x, y;
+
+    if (!m_dim[0].cellAt(point.x(), x) || !m_dim[1].cellAt(point.y(), y))
+        return false;
+
+    axesOut = Interval(x[0], y[0], x[1], y[1]);
+    return true;
+}
+
+
+//////////////////////////////////////////////////////////////////////////
+// Grid<3>
+
+template <>
+inline Grid<3>::Range Grid<3>::interval(const Interval& axes) const
+{
+    auto iv0 = m_dim[0].interval(uvec2(axes.min().x(), axes.max().x()));
+    auto iv1 = m_dim[1].interval(uvec2(axes.min().y(), axes.max().y()));
+    auto iv2 = m_dim[2].interval(uvec2(axes.min().z(), axes.max().z()));
+
+    return Range(vec3(iv0[0], iv1[0], iv2[0]), vec3(iv0[1], iv1[1], iv2[1]));
+}
+
+template <>
+inline Grid<3>::Range Grid<3>::range() const
+{
+    return Range(
+        vec3(m_dim[0].range()[0], m_dim[1].range()[0], m_dim[2].range()[0]),
+        vec3(m_dim[0].range()[1], m_dim[1].range()[1], m_dim[2].range()[1]));
+}
+
+template <>
+inline void Grid<3>::setRange(const Range& range)
+{
+    m_dim[0].setRange(vec2(range.min().x(), range.max().x()));
+    m_dim[1].setRange(vec2(range.min().y(), range.max().y()));
+    m_dim[2].setRange(vec2(range.min().z(), range.max().z()));
+}
+
+template <>
+inline bool Grid<3>::cellAt(const Point& point, Interval& axesOut) const
+{
+    uvec2 x, y, z;
+
+    if (!m_dim[0].cellAt(point.x(), x) || !m_dim[1].cellAt(point.y(), y) || !m_dim[2].cellAt(point.z(), z))
+        return false;
+
+    axesOut = Interval(uvec3(x[0], y[0], z[0]), uvec3(x[1], y[1], z[1]));
+    return true;
+}
+
 } // ns math
 
 typedef math::Grid<1> grid1;
 typedef math::Grid<2> grid2;
+typedef math::Grid<3> grid3;
 
 } // ns mcr
@@ -2,10 +2,125 @@
 
 #include <utility>
 #include <mcr/math/Vector.h>
+#include <mcr/math/Simd.h>
 
 namespace mcr  {
 namespace math {
 
+namespace detail {
+
+// Scalar 4x4 kernels on row-major arrays, vectors being rows (v * M).
+// For floats, the SIMD overloads below take precedence; the templates
+// can still be called explicitly, e.g. multiply4x4<float>(...).
+
+template <typename T>
+inline void transpose4x4(T* m)
+{
+    std::swap(m[ 1], m[ 4]);
+    std::swap(m[ 2], m[ 8]);
+    std::swap(m[ 3], m[12]);
+    std::swap(m[ 6], m[ 9]);
+    std::swap(m[ 7], m[13]);
+    std::swap(m[11], m[14]);
+}
+
+//! out = v * m
+template <typename T>
+inline void transform4(const T* v, const T* m, T* out)
+{
+    T r[4];
+
+    for (int j = 0; j < 4; ++j)
+        r[j] = v[0] * m[j] + v[1] * m[4 + j] + v[2] * m[8 + j] + v[3] * m[12 + j];
+
+    for (int j = 0; j < 4; ++j)
+        out[j] = r[j];
+}
+
+//! Each row of out is that row of \c rhs transformed by \c lhs
+template <typename T>
+inline void multiply4x4(const T* lhs, const T* rhs, T* out)
+{
+    T r[16];
+
+    for (int i = 0; i < 4; ++i)
+        transform4(rhs + 4 * i, lhs, r + 4 * i);
+
+    for (int i = 0; i < 16; ++i)
+        out[i] = r[i];
+}
+
+template <typename T>
+inline bool inverse4x4(const T* m, T* out)
+{
+    T inv[16];
+
+    inv[ 0] = + m[ 5] * m[10] * m[15] - m[ 5] * m[11] * m[14] - m[ 9] * m[ 6] * m[15]
+              + m[ 9] * m[ 7] * m[14] + m[13] * m[ 6] * m[11] - m[13] * m[ 7] * m[10];
+    inv[ 4] = - m[ 4] * m[10] * m[15] + m[ 4] * m[11] * m[14] + m[ 8] * m[ 6] * m[15]
+              - m[ 8] * m[ 7] * m[14] - m[12] * m[ 6] * m[11] + m[12] * m[ 7] * m[10];
+    inv[ 8] = + m[ 4] * m[ 9] * m[15] - m[ 4] * m[11] * m[13] - m[ 8] * m[ 5] * m[15]
+              + m[ 8] * m[ 7] * m[13] + m[12] * m[ 5] * m[11] - m[12] * m[ 7] * m[ 9];
+    inv[12] = - m[ 4] * m[ 9] * m[14] + m[ 4] * m[10] * m[13] + m[ 8] * m[ 5] * m[14]
+              - m[ 8] * m[ 6] * m[13] - m[12] * m[ 5] * m[10] + m[12] * m[ 6] * m[ 9];
+
+    T det = m[0] * inv[0] + m[1] * inv[4] + m[2] * inv[8] + m[3] * inv[12];
+
+    //if (math::equals(det, T(0)))
+    if (det == T(0))
+        return false;
+
+    det = T(1) / det;
+
+    inv[ 1] = - m[ 1] * m[10] * m[15] + m[ 1] * m[11] * m[14] + m[ 9] * m[ 2] * m[15]
+              - m[ 9] * m[ 3] * m[14] - m[13] * m[ 2] * m[11] + m[13] * m[ 3] * m[10];
+    inv[ 5] = + m[ 0] * m[10] * m[15] - m[ 0] * m[11] * m[14] - m[ 8] * m[ 2] * m[15]
+              + m[ 8] * m[ 3] * m[14] + m[12] * m[ 2] * m[11] - m[12] * m[ 3] * m[10];
+    inv[ 9] = - m[ 0] * m[ 9] * m[15] + m[ 0] * m[11] * m[13] + m[ 8] * m[ 1] * m[15]
+              - m[ 8] * m[ 3] * m[13] - m[12] * m[ 1] * m[11] + m[12] * m[ 3] * m[ 9];
+    inv[13] = + m[ 0] * m[ 9] * m[14] - m[ 0] * m[10] * m[13] - m[ 8] * m[ 1] * m[14]
+              + m[ 8] * m[ 2] * m[13] + m[12] * m[ 1] * m[10] - m[12] * m[ 2] * m[ 9];
+    inv[ 2] = + m[ 1] * m[ 6] * m[15] - m[ 1] * m[ 7] * m[14] - m[ 5] * m[ 2] * m[15]
+              + m[ 5] * m[ 3] * m[14] + m[13] * m[ 2] * m[ 7] - m[13] * m[ 3] * m[ 6];
+    inv[ 6] = - m[ 0] * m[ 6] * m[15] + m[ 0] * m[ 7] * m[14] + m[ 4] * m[ 2] * m[15]
+              - m[ 4] * m[ 3] * m[14] - m[12] * m[ 2] * m[ 7] + m[12] * m[ 3] * m[ 6];
+    inv[10] = + m[ 0] * m[ 5] * m[15] - m[ 0] * m[ 7] * m[13] - m[ 4] * m[ 1] * m[15]
+              + m[ 4] * m[ 3] * m[13] + m[12] * m[ 1] * m[ 7] - m[12] * m[ 3] * m[ 5];
+    inv[14] = - m[ 0] * m[ 5] * m[14] + m[ 0] * m[ 6] * m[13] + m[ 4] * m[ 1] * m[14]
+              - m[ 4] * m[ 2] * m[13] - m[12] * m[ 1] * m[ 6] + m[12] * m[ 2] * m[ 5];
+    inv[ 3] = - m[ 1] * m[ 6] * m[11] + m[ 1] * m[ 7] * m[10] + m[ 5] * m[ 2] * m[11]
+              - m[ 5] * m[ 3] * m[10] - m[ 9] * m[ 2] * m[ 7] + m[ 9] * m[ 3] * m[ 6];
+    inv[ 7] = + m[ 0] * m[ 6] * m[11] - m[ 0] * m[ 7] * m[10] - m[ 4] * m[ 2] * m[11]
+              + m[ 4] * m[ 3] * m[10] + m[ 8] * m[ 2] * m[ 7] - m[ 8] * m[ 3] * m[ 6];
+    inv[11] = - m[ 0] * m[ 5] * m[11] + m[ 0] * m[ 7] * m[ 9] + m[ 4] * m[ 1] * m[11]
+              - m[ 4] * m[ 3] * m[ 9] - m[ 8] * m[ 1] * m[ 7] + m[ 8] * m[ 3] * m[ 5];
+    inv[15] = + m[ 0] * m[ 5] * m[10] - m[ 0] * m[ 6] * m[ 9] - m[ 4] * m[ 1] * m[10]
+              + m[ 4] * m[ 2] * m[ 9] + m[ 8] * m[ 1] * m[ 6] - m[ 8] * m[ 2] * m[ 5];
+                  
+    for (auto i = 0; i < 16; ++i)
+        out[i] = inv[i] * det;
+
+    return true;
+}
+
+#ifdef MCR_MATH_SIMD
+inline void transpose4x4(float* m)
+{ simd::transpose(m); }
+
+inline void transform4(const float* v, const float* m, float* out)
+{ simd::transform(v, m, out); }
+
+inline void multiply4x4(const float* lhs, const float* rhs, float* out)
+{ simd::multiply(lhs, rhs, out); }
+
+#   ifdef MCR_MATH_SIMD_INVERSE
+inline bool inverse4x4(const float* m, float* out)
+{ return simd::inverse(m, out); }
+#   endif
+#endif
+
+} // ns detail
+
 template <typename T>
 class Matrix4x4
 {
@@ -61,68 +176,12 @@ public:
 
     Matrix4x4<T>& transpose()
     {
-        std::swap(m_elements[ 1], m_elements[ 4]);
-        std::swap(m_elements[ 2], m_elements[ 8]);
-        std::swap(m_elements[ 3], m_elements[12]);
-        std::swap(m_elements[ 6], m_elements[ 9]);
-        std::swap(m_elements[ 7], m_elements[13]);
-        std::swap(m_elements[11], m_elements[14]);
-
+        detail::transpose4x4(m_elements);
         return *this;
     }
 
     bool inverse(Matrix4x4<T>& result)
-    {
-        Matrix4x4<T> inv(false);
-        auto m = &m_elements[0];
-
-        inv[ 0] = + m[ 5] * m[10] * m[15] - m[ 5] * m[11] * m[14] - m[ 9] * m[ 6] * m[15]
-                  + m[ 9] * m[ 7] * m[14] + m[13] * m[ 6] * m[11] - m[13] * m[ 7] * m[10];
-        inv[ 4] = - m[ 4] * m[10] * m[15] + m[ 4] * m[11] * m[14] + m[ 8] * m[ 6] * m[15]
-                  - m[ 8] * m[ 7] * m[14] - m[12] * m[ 6] * m[11] + m[12] * m[ 7] * m[10];
-        inv[ 8] = + m[ 4] * m[ 9] * m[15] - m[ 4] * m[11] * m[13] - m[ 8] * m[ 5] * m[15]
-                  + m[ 8] * m[ 7] * m[13] + m[12] * m[ 5] * m[11] - m[12] * m[ 7] * m[ 9];
-        inv[12] = - m[ 4] * m[ 9] * m[14] + m[ 4] * m[10] * m[13] + m[ 8] * m[ 5] * m[14]
-                  - m[ 8] * m[ 6] * m[13] - m[12] * m[ 5] * m[10] + m[12] * m[ 6] * m[ 9];
-
-        T det = m[0] * inv[0] + m[1] * inv[4] + m[2] * inv[8] + m[3] * inv[12];
-
-        //if (math::equals(det, T(0)))
-        if (det == T(0))
-            return false;
-
-        det = T(1) / det;
-
-        inv[ 1] = - m[ 1] * m[10] * m[15] + m[ 1] * m[11] * m[14] + m[ 9] * m[ 2] * m[15]
-                  - m[ 9] * m[ 3] * m[14] - m[13] * m[ 2] * m[11] + m[13] * m[ 3] * m[10];
-        inv[ 5] = + m[ 0] * m[10] * m[15] - m[ 0] * m[11] * m[14] - m[ 8] * m[ 2] * m[15]
-                  + m[ 8] * m[ 3] * m[14] + m[12] * m[ 2] * m[11] - m[12] * m[ 3] * m[10];
-        inv[ 9] = - m[ 0] * m[ 9] * m[15] + m[ 0] * m[11] * m[13] + m[ 8] * m[ 1] * m[15]
-                  - m[ 8] * m[ 3] * m[13] - m[12] * m[ 1] * m[11] + m[12] * m[ 3] * m[ 9];
-        inv[13] = + m[ 0] * m[ 9] * m[14] - m[ 0] * m[10] * m[13] - m[ 8] * m[ 1] * m[14]
-                  + m[ 8] * m[ 2] * m[13] + m[12] * m[ 1] * m[10] - m[12] * m[ 2] * m[ 9];
-        inv[ 2] = + m[ 1] * m[ 6] * m[15] - m[ 1] * m[ 7] * m[14] - m[ 5] * m[ 2] * m[15]
-                  + m[ 5] * m[ 3] * m[14] + m[13] * m[ 2] * m[ 7] - m[13] * m[ 3] * m[ 6];
-        inv[ 6] = - m[ 0] * m[ 6] * m[15] + m[ 0] * m[ 7] * m[14] + m[ 4] * m[ 2] * m[15]
-                  - m[ 4] * m[ 3] * m[14] - m[12] * m[ 2] * m[ 7] + m[12] * m[ 3] * m[ 6];
-        inv[10] = + m[ 0] * m[ 5] * m[15] - m[ 0] * m[ 7] * m[13] - m[ 4] * m[ 1] * m[15]
-                  + m[ 4] * m[ 3] * m[13] + m[12] * m[ 1] * m[ 7] - m[12] * m[ 3] * m[ 5];
-        inv[14] = - m[ 0] * m[ 5] * m[14] + m[ 0] * m[ 6] * m[13] + m[ 4] * m[ 1] * m[14]
-                  - m[ 4] * m[ 2] * m[13] - m[12] * m[ 1] * m[ 6] + m[12] * m[ 2] * m[ 5];
-        inv[ 3] = - m[ 1] * m[ 6] * m[11] + m[ 1] * m[ 7] * m[10] + m[ 5] * m[ 2] * m[11]
-                  - m[ 5] * m[ 3] * m[10] - m[ 9] * m[ 2] * m[ 7] + m[ 9] * m[ 3] * m[ 6];
-        inv[ 7] = + m[ 0] * m[ 6] * m[11] - m[ 0] * m[ 7] * m[10] - m[ 4] * m[ 2] * m[11]
-                  + m[ 4] * m[ 3] * m[10] + m[ 8] * m[ 2] * m[ 7] - m[ 8] * m[ 3] * m[ 6];
-        inv[11] = - m[ 0] * m[ 5] * m[11] + m[ 0] * m[ 7] * m[ 9] + m[ 4] * m[ 1] * m[11]
-                  - m[ 4] * m[ 3] * m[ 9] - m[ 8] * m[ 1] * m[ 7] + m[ 8] * m[ 3] * m[ 5];
-        inv[15] = + m[ 0] * m[ 5] * m[10] - m[ 0] * m[ 6] * m[ 9] - m[ 4] * m[ 1] * m[10]
-                  + m[ 4] * m[ 2] * m[ 9] + m[ 8] * m[ 1] * m[ 6] - m[ 8] * m[ 2] * m[ 5];
-                      
-        for (auto i = 0; i < 16; ++i)
-            result[i] = inv[i] * det;
-
-        return true;
-    }
+    { return detail::inverse4x4(m_elements, result.m_elements); }
 
         
     const Vector<T, 3>& translation() const
@@ -256,12 +315,8 @@ inline bool operator==(const Matrix4x4<T>& lhs, const Matrix4x4<T>& rhs)
 template <typename T>
 inline Matrix4x4<T> operator*(const Matrix4x4<T>& lhs, const Matrix4x4<T>& rhs)
 {
-    Matrix4x4<T> result;
-
-    result.template vecAt<4>( 0) = rhs.template vecAt<4>( 0) * lhs;
-    result.template vecAt<4>( 4) = rhs.template vecAt<4>( 4) * lhs;
-    result.template vecAt<4>( 8) = rhs.template vecAt<4>( 8) * lhs;
-    result.template vecAt<4>(12) = rhs.template vecAt<4>(12) * lhs;
+    Matrix4x4<T> result(false);
+    detail::multiply4x4(&lhs[0], &rhs[0], &result[0]);
 
     return result;
 }
@@ -284,10 +339,10 @@ inline Vector<T, 3> operator*(const Vector<T, 3>& lhs, const Matrix4x4<T>& rhs)
 template <typename T>
 inline Vector<T, 4> operator*(const Vector<T, 4>& lhs, const Matrix4x4<T>& rhs)
 {
-    return lhs.x() * rhs.template vecAt<4>(0)
-         + lhs.y() * rhs.template vecAt<4>(4)
-         + lhs.z() * rhs.template vecAt<4>(8)
-         + lhs.w() * rhs.template vecAt<4>(12);
+    Vector<T, 4> result;
+    detail::transform4(static_cast<const T*>(lhs), &rhs[0], static_cast<T*>(result));
+
+    return result;
 }
 
 template <typename T, int n>
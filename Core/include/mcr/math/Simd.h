@@ -0,0 +1,328 @@
+#pragma once
+
+// Define MCR_MATH_NO_SIMD to build the plain scalar math everywhere
+
+#if !defined(MCR_MATH_NO_SIMD)
+#   if defined(__SSE__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 1)
+#       define MCR_MATH_SSE
+#   elif defined(__ARM_NEON) || defined(__ARM_NEON__)
+#       define MCR_MATH_NEON
+#   endif
+#endif
+
+#if defined(MCR_MATH_SSE)
+#   include <xmmintrin.h>
+#   if defined(__FMA__)
+#       include <immintrin.h>
+#   endif
+#   define MCR_MATH_SIMD
+#elif defined(MCR_MATH_NEON)
+#   include <arm_neon.h>
+#   define MCR_MATH_SIMD
+#endif
+
+#ifdef MCR_MATH_SIMD
+
+namespace mcr  {
+namespace math {
+namespace simd {
+
+//////////////////////////////////////////////////////////////////////////
+// Four floats at once; loads and stores don't need any alignment
+
+#if defined(MCR_MATH_SSE)
+
+typedef __m128 float4;
+
+inline float4 load(const float* src)            { return _mm_loadu_ps(src); }
+inline void   store(float* dst, float4 v)       { _mm_storeu_ps(dst, v); }
+inline float4 splat(float f)                    { return _mm_set1_ps(f); }
+
+inline float4 add(float4 a, float4 b)           { return _mm_add_ps(a, b); }
+inline float4 sub(float4 a, float4 b)           { return _mm_sub_ps(a, b); }
+inline float4 mul(float4 a, float4 b)           { return _mm_mul_ps(a, b); }
+
+//! a * b + c
+inline float4 madd(float4 a, float4 b, float4 c)
+{
+#   if defined(__FMA__)
+    return _mm_fmadd_ps(a, b, c);
+#   else
+    return _mm_add_ps(_mm_mul_ps(a, b), c);
+#   endif
+}
+
+inline void transpose(float4& r0, float4& r1, float4& r2, float4& r3)
+{
+    _MM_TRANSPOSE4_PS(r0, r1, r2, r3);
+}
+
+inline float4 invSqrt(float4 a)                 { return _mm_div_ps(_mm_set1_ps(1.f), _mm_sqrt_ps(a)); }
+
+//! All bits set in the lanes where a > b
+inline float4 greater(float4 a, float4 b)       { return _mm_cmpgt_ps(a, b); }
+
+//! Lanes of \c a where \c mask is set, of \c b elsewhere
+inline float4 select(float4 mask, float4 a, float4 b)
+{
+    return _mm_or_ps(_mm_and_ps(mask, a), _mm_andnot_ps(mask, b));
+}
+
+//! Four packed xyz triplets (12 floats) to and from a register per component
+inline void load3(const float* src, float4& x, float4& y, float4& z)
+{
+    __m128
+        a = _mm_loadu_ps(src),      // x0 y0 z0 x1
+        b = _mm_loadu_ps(src + 4),  // y1 z1 x2 y2
+        c = _mm_loadu_ps(src + 8);  // z2 x3 y3 z3
+
+    x = _mm_shuffle_ps(a, _mm_shuffle_ps(b, c, _MM_SHUFFLE(1, 1, 2, 2)), _MM_SHUFFLE(2, 0, 3, 0));
+    y = _mm_shuffle_ps(_mm_shuffle_ps(a, b, _MM_SHUFFLE(0, 0, 1, 1)),
+                       _mm_shuffle_ps(b, c, _MM_SHUFFLE(2, 2, 3, 3)), _MM_SHUFFLE(2, 0, 2, 0));
+    z = _mm_shuffle_ps(_mm_shuffle_ps(a, b, _MM_SHUFFLE(1, 1, 2, 2)), c, _MM_SHUFFLE(3, 0, 2, 0));
+}
+
+inline void store3(float* dst, float4 x, float4 y, float4 z)
+{
+    _mm_storeu_ps(dst,     _mm_shuffle_ps(_mm_shuffle_ps(x, y, _MM_SHUFFLE(0, 0, 0, 0)),
+                                          _mm_shuffle_ps(z, x, _MM_SHUFFLE(1, 1, 0, 0)), _MM_SHUFFLE(2, 0, 2, 0)));
+    _mm_storeu_ps(dst + 4, _mm_shuffle_ps(_mm_shuffle_ps(y, z, _MM_SHUFFLE(1, 1, 1, 1)),
+                                          _mm_shuffle_ps(x, y, _MM_SHUFFLE(2, 2, 2, 2)), _MM_SHUFFLE(2, 0, 2, 0)));
+    _mm_storeu_ps(dst + 8, _mm_shuffle_ps(_mm_shuffle_ps(z, x, _MM_SHUFFLE(3, 3, 2, 2)),
+                                          _mm_shuffle_ps(y, z, _MM_SHUFFLE(3, 3, 3, 3)), _MM_SHUFFLE(2, 0, 2, 0)));
+}
+
+#elif defined(MCR_MATH_NEON)
+
+typedef float32x4_t float4;
+
+inline float4 load(const float* src)            { return vld1q_f32(src); }
+inline void   store(float* dst, float4 v)       { vst1q_f32(dst, v); }
+inline float4 splat(float f)                    { return vdupq_n_f32(f); }
+
+inline float4 add(float4 a, float4 b)           { return vaddq_f32(a, b); }
+inline float4 sub(float4 a, float4 b)           { return vsubq_f32(a, b); }
+inline float4 mul(float4 a, float4 b)           { return vmulq_f32(a, b); }
+
+//! a * b + c
+inline float4 madd(float4 a, float4 b, float4 c) { return vmlaq_f32(c, a, b); }
+
+inline void transpose(float4& r0, float4& r1, float4& r2, float4& r3)
+{
+    float32x4x2_t t01 = vtrnq_f32(r0, r1);
+    float32x4x2_t t23 = vtrnq_f32(r2, r3);
+
+    r0 = vcombine_f32(vget_low_f32 (t01.val[0]), vget_low_f32 (t23.val[0]));
+    r1 = vcombine_f32(vget_low_f32 (t01.val[1]), vget_low_f32 (t23.val[1]));
+    r2 = vcombine_f32(vget_high_f32(t01.val[0]), vget_high_f32(t23.val[0]));
+    r3 = vcombine_f32(vget_high_f32(t01.val[1]), vget_high_f32(t23.val[1]));
+}
+
+//! Estimate refined by two Newton-Raphson steps, as armv7 has no vector sqrt
+inline float4 invSqrt(float4 a)
+{
+    float4 r = vrsqrteq_f32(a);
+
+    r = vmulq_f32(r, vrsqrtsq_f32(vmulq_f32(a, r), r));
+    r = vmulq_f32(r, vrsqrtsq_f32(vmulq_f32(a, r), r));
+
+    return r;
+}
+
+//! All bits set in the lanes where a > b
+inline float4 greater(float4 a, float4 b)       { return vreinterpretq_f32_u32(vcgtq_f32(a, b)); }
+
+//! Lanes of \c a where \c mask is set, of \c b elsewhere
+inline float4 select(float4 mask, float4 a, float4 b)
+{
+    return vbslq_f32(vreinterpretq_u32_f32(mask), a, b);
+}
+
+//! Four packed xyz triplets (12 floats) to and from a register per component
+inline void load3(const float* src, float4& x, float4& y, float4& z)
+{
+    float32x4x3_t v = vld3q_f32(src);
+
+    x = v.val[0];
+    y = v.val[1];
+    z = v.val[2];
+}
+
+inline void store3(float* dst, float4 x, float4 y, float4 z)
+{
+    float32x4x3_t v = {{x, y, z}};
+    vst3q_f32(dst, v);
+}
+
+#endif
+
+
+//////////////////////////////////////////////////////////////////////////
+// 4x4 kernels on row-major float[16], vectors being rows (v * M)
+
+//! out = v * m; out may alias v
+inline void transform(const float* v, const float* m, float* out)
+{
+    float4 r = mul(splat(v[0]), load(m));
+
+    r = madd(splat(v[1]), load(m +  4), r);
+    r = madd(splat(v[2]), load(m +  8), r);
+    r = madd(splat(v[3]), load(m + 12), r);
+
+    store(out, r);
+}
+
+//! Same as Matrix4x4's operator*: each row of out is that row of \c rhs
+//! transformed by \c lhs. out may alias either operand.
+inline void multiply(const float* lhs, const float* rhs, float* out)
+{
+    float4
+        l0 = load(lhs),
+        l1 = load(lhs +  4),
+        l2 = load(lhs +  8),
+        l3 = load(lhs + 12);
+
+    float4 rows[4];
+
+    for (int i = 0; i < 4; ++i)
+    {
+        const float* r = rhs + 4 * i;
+
+        rows[i] = madd(splat(r[3]), l3,
+                  madd(splat(r[2]), l2,
+                  madd(splat(r[1]), l1,
+                   mul(splat(r[0]), l0))));
+    }
+
+    for (int i = 0; i < 4; ++i)
+        store(out + 4 * i, rows[i]);
+}
+
+inline void transpose(float* m)
+{
+    float4
+        r0 = load(m),
+        r1 = load(m +  4),
+        r2 = load(m +  8),
+        r3 = load(m + 12);
+
+    transpose(r0, r1, r2, r3);
+
+    store(m,      r0);
+    store(m +  4, r1);
+    store(m +  8, r2);
+    store(m + 12, r3);
+}
+
+#if defined(MCR_MATH_SSE)
+
+#define MCR_SIMD_SHUFFLE(a, b, x, y, z, w) _mm_shuffle_ps(a, b, _MM_SHUFFLE(w, z, y, x))
+#define MCR_SIMD_SWIZZLE(a, x, y, z, w)    _mm_shuffle_ps(a, a, _MM_SHUFFLE(w, z, y, x))
+
+namespace detail {
+
+// 2x2 matrices packed as (m00, m01, m10, m11); # is the adjugate
+
+// a * b
+inline float4 mul2x2(float4 a, float4 b)
+{
+    return _mm_add_ps(_mm_mul_ps(a, MCR_SIMD_SWIZZLE(b, 0, 3, 0, 3)),
+                      _mm_mul_ps(MCR_SIMD_SWIZZLE(a, 1, 0, 3, 2), MCR_SIMD_SWIZZLE(b, 2, 1, 2, 1)));
+}
+
+// a# * b
+inline float4 adjMul2x2(float4 a, float4 b)
+{
+    return _mm_sub_ps(_mm_mul_ps(MCR_SIMD_SWIZZLE(a, 3, 3, 0, 0), b),
+                      _mm_mul_ps(MCR_SIMD_SWIZZLE(a, 1, 1, 2, 2), MCR_SIMD_SWIZZLE(b, 2, 3, 0, 1)));
+}
+
+// a * b#
+inline float4 mulAdj2x2(float4 a, float4 b)
+{
+    return _mm_sub_ps(_mm_mul_ps(a, MCR_SIMD_SWIZZLE(b, 3, 0, 3, 0)),
+                      _mm_mul_ps(MCR_SIMD_SWIZZLE(a, 1, 0, 3, 2), MCR_SIMD_SWIZZLE(b, 2, 1, 2, 1)));
+}
+
+} // ns detail
+
+//! Blockwise inversion through 2x2 adjugates; false if \c m is singular,
+//! in which case out is left alone. out may alias m.
+inline bool inverse(const float* m, float* out)
+{
+    using namespace detail;
+
+    float4
+        r0 = load(m),
+        r1 = load(m +  4),
+        r2 = load(m +  8),
+        r3 = load(m + 12);
+
+    // | A B |
+    // | C D |
+    float4
+        A = _mm_movelh_ps(r0, r1),
+        B = _mm_movehl_ps(r1, r0),
+        C = _mm_movelh_ps(r2, r3),
+        D = _mm_movehl_ps(r3, r2);
+
+    // (|A|, |B|, |C|, |D|)
+    float4 detSub = _mm_sub_ps(
+        _mm_mul_ps(MCR_SIMD_SHUFFLE(r0, r2, 0, 2, 0, 2), MCR_SIMD_SHUFFLE(r1, r3, 1, 3, 1, 3)),
+        _mm_mul_ps(MCR_SIMD_SHUFFLE(r0, r2, 1, 3, 1, 3), MCR_SIMD_SHUFFLE(r1, r3, 0, 2, 0, 2)));
+
+    float4
+        detA = MCR_SIMD_SWIZZLE(detSub, 0, 0, 0, 0),
+        detB = MCR_SIMD_SWIZZLE(detSub, 1, 1, 1, 1),
+        detC = MCR_SIMD_SWIZZLE(detSub, 2, 2, 2, 2),
+        detD = MCR_SIMD_SWIZZLE(detSub, 3, 3, 3, 3);
+
+    float4
+        DC = adjMul2x2(D, C),
+        AB = adjMul2x2(A, B);
+
+    // Adjugates of the inverse's blocks
+    float4
+        X = _mm_sub_ps(_mm_mul_ps(detD, A), mul2x2(B, DC)),
+        W = _mm_sub_ps(_mm_mul_ps(detA, D), mul2x2(C, AB)),
+        Y = _mm_sub_ps(_mm_mul_ps(detB, C), mulAdj2x2(D, AB)),
+        Z = _mm_sub_ps(_mm_mul_ps(detC, B), mulAdj2x2(A, DC));
+
+    // |M| = |A||D| + |B||C| - tr((A#B)(D#C))
+    float4 tr = _mm_mul_ps(AB, MCR_SIMD_SWIZZLE(DC, 0, 2, 1, 3));
+    tr = _mm_add_ps(tr, MCR_SIMD_SWIZZLE(tr, 2, 3, 0, 1));
+    tr = _mm_add_ps(tr, MCR_SIMD_SWIZZLE(tr, 1, 0, 3, 2));
+
+    float4 det = _mm_sub_ps(_mm_add_ps(_mm_mul_ps(detA, detD), _mm_mul_ps(detB, detC)), tr);
+
+    if (_mm_cvtss_f32(det) == 0.f)
+        return false;
+
+    float4 invDet = _mm_div_ps(_mm_setr_ps(1.f, -1.f, -1.f, 1.f), det);
+
+    X = _mm_mul_ps(X, invDet);
+    Y = _mm_mul_ps(Y, invDet);
+    Z = _mm_mul_ps(Z, invDet);
+    W = _mm_mul_ps(W, invDet);
+
+    // Undo the adjugates while putting the blocks back together
+    store(out,      MCR_SIMD_SHUFFLE(X, Y, 3, 1, 3, 1));
+    store(out +  4, MCR_SIMD_SHUFFLE(X, Y, 2, 0, 2, 0));
+    store(out +  8, MCR_SIMD_SHUFFLE(Z, W, 3, 1, 3, 1));
+    store(out + 12, MCR_SIMD_SHUFFLE(Z, W, 2, 0, 2, 0));
+
+    return true;
+}
+
+#undef MCR_SIMD_SWIZZLE
+#undef MCR_SIMD_SHUFFLE
+
+#define MCR_MATH_SIMD_INVERSE
+
+#endif // MCR_MATH_SSE
+
+} // ns simd
+} // ns math
+} // ns mcr
+
+#endif // MCR_MATH_SIMD
@@ -0,0 +1,58 @@
+#pragma once
+
+#include <mcr/math/Box.h>
+
+namespace mcr  {
+namespace math {
+
+template <typename T>
+class Sphere
+{
+public:
+    Sphere<T>():
+        m_center(), m_radius() {}
+
+    Sphere<T>(const Vector<T, 3>& center, T radius):
+        m_center(center), m_radius(radius) {}
+
+
+    const Vector<T, 3>& center() const { return m_center; }
+    T                   radius() const { return m_radius; }
+
+    void setCenter(const Vector<T, 3>& center) { m_center = center; }
+    void setRadius(T radius)                   { m_radius = radius; }
+
+    bool contains(const Vector<T, 3>& point) const
+    {
+        return lengthSq(point - m_center) <= m_radius * m_radius;
+    }
+
+protected:
+    Vector<T, 3> m_center;
+    T            m_radius;
+};
+
+//! Sphere around the box's center through its corners
+template <typename T>
+inline Sphere<T> boundingSphere(const Box<T>& box)
+{
+    return box.isEmpty() ? Sphere<T>() : Sphere<T>(box.center(), length(box.extent()));
+}
+
+//! The sphere bounding \c sphere once transformed by \c m, which may scale unevenly
+template <typename T>
+inline Sphere<T> transform(const Sphere<T>& sphere, const Matrix4x4<T>& m)
+{
+    T scale = std::sqrt(std::max(lengthSq(m.template vecAt<3>(0)),
+                        std::max(lengthSq(m.template vecAt<3>(4)),
+                                 lengthSq(m.template vecAt<3>(8)))));
+
+    return Sphere<T>(sphere.center() * m + m.translation(), sphere.radius() * scale);
+}
+
+} // ns math
+
+typedef math::Sphere<float> sphere;
+typedef math::Sphere<double> dsphere;
+
+} // ns mcr
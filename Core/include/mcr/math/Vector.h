@@ -154,7 +154,7 @@ public:
     { return m_x += rhs.x(), m_y += rhs.y(), m_z += rhs.z(), m_w += rhs.w(), *this; }
 
     Vector<T, 4>& operator-=(const Vector<T, 4>& rhs)
-    { return m_x -= rhs.x(), m_y -= rhs.y(), m_z -= rhs.z(), m_w == rhs.w(), *this; }
+    { return m_x -= rhs.x(), m_y -= rhs.y(), m_z -= rhs.z(), m_w -= rhs.w(), *this; }
 
     Vector<T, 4>& operator*=(const Vector<T, 4>& rhs)
     { return m_x *= rhs.x(), m_y *= rhs.y(), m_z *= rhs.z(), m_w *= rhs.w(), *this; }
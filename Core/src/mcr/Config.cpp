@@ -19,10 +19,10 @@ bool Config::load(io::IReader* stream, bool report)
     for (io::LineParser parser(stream); parser.readLine();)
     {
         char key[128], value[128];
-        if (std::sscanf(parser.line().c_str(), "%127[^=: \xA0\t] %*1[=:] %127s", key, value) != 2)
+        if (std::sscanf(parser.line(), "%127[^=: \xA0\t] %*1[=:] %127s", key, value) != 2)
         {
             if (report)
-                g_log->warn("Config syntax error: %s", parser.line().c_str());
+                g_log->warn("Config syntax error: %s", parser.line());
 
             return false;
         }
@@ -0,0 +1,53 @@
+#include <mcr/Name.h>
+
+#include <deque>
+#include <mutex>
+#include <mcr/FlatHashMap.h>
+
+namespace mcr {
+
+namespace {
+
+struct Registry
+{
+    std::mutex                          mutex;
+    std::deque<std::string>             strings; // don't move when growing
+    FlatHashMap<Name, const char*>      byName;
+};
+
+Registry& registry()
+{
+    static Registry instance;
+    return instance;
+}
+
+} // ns
+
+
+Name Name::intern(const char* str)
+{
+    Name name(str);
+
+    auto& reg = registry();
+    std::lock_guard<std::mutex> lock(reg.mutex);
+
+    auto& entry = reg.byName[name];
+    if (!entry)
+    {
+        reg.strings.push_back(str);
+        entry = reg.strings.back().c_str();
+    }
+
+    return name;
+}
+
+const char* Name::str() const
+{
+    auto& reg = registry();
+    std::lock_guard<std::mutex> lock(reg.mutex);
+
+    auto it = reg.byName.find(*this);
+    return it != reg.byName.end() ? it->second : "";
+}
+
+} // ns mcr
@@ -0,0 +1,209 @@
+#include <mcr/Profiler.h>
+
+#include <chrono>
+#include <cstdio>
+#include <deque>
+#include <mutex>
+#include <string>
+#include <vector>
+
+namespace mcr {
+
+namespace {
+
+struct Zone
+{
+    const char* name;
+    int64       start, duration;
+};
+
+} // ns
+
+//! A ring with a single writer; readers take what's below the head
+struct Profiler::Track
+{
+    std::string             name;
+    uint                    id;
+    std::vector<Zone>       zones;
+    std::atomic<uint64>     head;
+
+    Track(const std::string& aname, uint aid):
+        name(aname),
+        id(aid),
+        zones(Profiler::TrackCapacity),
+        head(0) {}
+
+    void push(const char* zname, int64 start, int64 duration)
+    {
+        auto index = head.load(std::memory_order_relaxed);
+
+        auto& zone = zones[index % Profiler::TrackCapacity];
+        zone.name     = zname;
+        zone.start    = start;
+        zone.duration = duration;
+
+        head.store(index + 1, std::memory_order_release);
+    }
+};
+
+
+namespace {
+
+typedef Profiler::Track Track;
+
+struct Registry
+{
+    std::mutex          mutex;
+    std::deque<Track>   tracks; // don't move when growing, so recording needs no lock
+
+    //! Threads get a numbered name until they set one
+    Track& add(const char* name)
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+
+        char numbered[32];
+        if (!name)
+        {
+            std::sprintf(numbered, "Thread %u", (uint) tracks.size());
+            name = numbered;
+        }
+
+        tracks.emplace_back(name, (uint) tracks.size());
+        return tracks.back();
+    }
+};
+
+Registry& registry()
+{
+    static Registry instance;
+    return instance;
+}
+
+thread_local Track* t_track = nullptr;
+
+Track& threadTrack()
+{
+    if (!t_track)
+        t_track = &registry().add(nullptr);
+
+    return *t_track;
+}
+
+void appendEscaped(std::string& out, const char* str)
+{
+    for (; *str; ++str)
+    {
+        if (*str == '"' || *str == '\\')
+            out += '\\';
+
+        out += *str;
+    }
+}
+
+} // ns
+
+
+std::atomic<bool> Profiler::s_enabled(false);
+
+int64 Profiler::now()
+{
+    using namespace std::chrono;
+    return duration_cast<nanoseconds>(steady_clock::now().time_since_epoch()).count();
+}
+
+void Profiler::setEnabled(bool enabled)
+{
+    s_enabled.store(enabled);
+}
+
+void Profiler::record(const char* name, int64 start, int64 duration)
+{
+    threadTrack().push(name, start, duration);
+}
+
+Profiler::Track* Profiler::track(const char* name)
+{
+    return &registry().add(name);
+}
+
+void Profiler::record(Track* track, const char* name, int64 start, int64 duration)
+{
+    track->push(name, start, duration);
+}
+
+void Profiler::setThreadName(const char* name)
+{
+    auto& track = threadTrack();
+
+    std::lock_guard<std::mutex> lock(registry().mutex);
+    track.name = name;
+}
+
+bool Profiler::writeChromeTrace(io::IWriter* out)
+{
+    if (!out)
+        return false;
+
+    auto& reg = registry();
+    std::lock_guard<std::mutex> lock(reg.mutex);
+
+    // Timestamps are in microseconds, from the earliest zone on
+    int64 epoch = -1;
+
+    for (auto it = reg.tracks.begin(); it != reg.tracks.end(); ++it)
+    {
+        uint64 head  = it->head.load(std::memory_order_acquire);
+        uint64 first = head > TrackCapacity ? head - TrackCapacity : 0;
+
+        for (auto i = first; i < head; ++i)
+        {
+            auto start = it->zones[i % TrackCapacity].start;
+
+            if (epoch < 0 || start < epoch)
+                epoch = start;
+        }
+    }
+
+    std::string json = "{\"traceEvents\":[\n";
+    char buffer[128];
+
+    for (auto it = reg.tracks.begin(); it != reg.tracks.end(); ++it)
+    {
+        std::sprintf(buffer, "{\"ph\":\"M\",\"name\":\"thread_name\",\"pid\":1,\"tid\":%u,\"args\":{\"name\":\"", it->id);
+        json += buffer;
+        appendEscaped(json, it->name.c_str());
+        json += "\"}}";
+
+        uint64 head  = it->head.load(std::memory_order_acquire);
+        uint64 first = head > TrackCapacity ? head - TrackCapacity : 0;
+
+        for (auto i = first; i < head; ++i)
+        {
+            auto& zone = it->zones[i % TrackCapacity];
+
+            json += ",\n{\"ph\":\"X\",\"name\":\"";
+            appendEscaped(json, zone.name);
+
+            std::sprintf(buffer, "\",\"pid\":1,\"tid\":%u,\"ts\":%.3f,\"dur\":%.3f}",
+                         it->id, (zone.start - epoch) / 1e3, zone.duration / 1e3);
+            json += buffer;
+        }
+
+        json += it + 1 != reg.tracks.end() ? ",\n" : "\n";
+    }
+
+    json += "]}\n";
+
+    return out->write(json.data(), json.size()) == json.size();
+}
+
+void Profiler::clear()
+{
+    auto& reg = registry();
+    std::lock_guard<std::mutex> lock(reg.mutex);
+
+    for (auto it = reg.tracks.begin(); it != reg.tracks.end(); ++it)
+        it->head.store(0);
+}
+
+} // ns mcr
@@ -0,0 +1,83 @@
+#include <mcr/ThreadPool.h>
+
+namespace mcr {
+
+ThreadPool::ThreadPool(uint numThreads):
+    m_numBusy(0),
+    m_quit(false)
+{
+    if (!numThreads)
+    {
+        auto numCores = std::thread::hardware_concurrency();
+        numThreads = numCores > 1 ? numCores - 1 : 1;
+    }
+
+    m_threads.reserve(numThreads);
+
+    for (uint i = 0; i < numThreads; ++i)
+        m_threads.push_back(std::thread(&ThreadPool::_work, this));
+}
+
+ThreadPool::~ThreadPool()
+{
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_quit = true;
+    }
+
+    m_taskAdded.notify_all();
+
+    for (auto it = m_threads.begin(); it != m_threads.end(); ++it)
+        it->join();
+}
+
+void ThreadPool::enqueue(const Task& task)
+{
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_tasks.push_back(task);
+    }
+
+    m_taskAdded.notify_one();
+}
+
+void ThreadPool::wait()
+{
+    std::unique_lock<std::mutex> lock(m_mutex);
+
+    while (!m_tasks.empty() || m_numBusy)
+        m_taskDone.wait(lock);
+}
+
+void ThreadPool::_work()
+{
+    for (;;)
+    {
+        Task task;
+
+        {
+            std::unique_lock<std::mutex> lock(m_mutex);
+
+            while (!m_quit && m_tasks.empty())
+                m_taskAdded.wait(lock);
+
+            if (m_tasks.empty()) // so we're quitting
+                return;
+
+            task = m_tasks.front();
+            m_tasks.pop_front();
+            ++m_numBusy;
+        }
+
+        task();
+
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            --m_numBusy;
+        }
+
+        m_taskDone.notify_all();
+    }
+}
+
+} // ns mcr
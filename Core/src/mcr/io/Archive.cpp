@@ -0,0 +1,259 @@
+#include <mcr/io/Archive.h>
+
+#include <algorithm>
+#include <cstring>
+#include <mcr/Name.h>
+#include <mcr/io/Lz4.h>
+#include <mcr/io/MemoryReader.h>
+
+namespace mcr {
+namespace io  {
+
+namespace {
+
+const char g_magic[4] = {'M', 'C', 'R', 'A'};
+const uint g_version  = 1;
+
+enum EntryFlags
+{
+    Compressed = 0x1
+};
+
+// Anything larger means the archive is corrupt; LZ4 can't expand data by
+// more than 255 times either
+const uint64 g_maxEntrySize = 1ull << 31;
+const uint64 g_maxLz4Ratio  = 255;
+
+struct Header
+{
+    char   magic[4];
+    uint   version;
+    uint   numEntries;
+    uint   alignment;
+    uint64 tocOffset;
+    uint64 namesOffset, namesSize;
+};
+
+//! Keeps the archive's data alive for a single reader, so that opening and
+//! dropping readers never touches a count shared between threads
+class DataRef: public RefCounted
+{
+public:
+    using RefCounted::operator new;
+    using RefCounted::operator delete;
+
+    explicit DataRef(const std::shared_ptr<rcptr<IFileReader>>& data): m_data(data) {}
+
+private:
+    std::shared_ptr<rcptr<IFileReader>> m_data;
+};
+
+uint64 alignUp(uint64 offset, uint alignment)
+{
+    return (offset + alignment - 1) / alignment * alignment;
+}
+
+bool writePadding(IWriter* out, uint64 size)
+{
+    static const byte s_zeros[256] = {};
+
+    for (std::size_t chunk; size; size -= chunk)
+    {
+        chunk = (std::size_t) std::min<uint64>(size, sizeof(s_zeros));
+
+        if (out->write(s_zeros, chunk) != chunk)
+            return false;
+    }
+
+    return true;
+}
+
+} // ns
+
+
+//////////////////////////////////////////////////////////////////////////
+// Reading
+
+rcptr<Archive> Archive::open(IFileReader* file)
+{
+    auto memory = MemoryReader::fromFile(file);
+    if (!memory || !memory->data())
+        return nullptr;
+
+    auto data = static_cast<const byte*>(memory->data());
+    auto size = memory->size();
+
+    Header header;
+
+    if (size < sizeof(header))
+        return nullptr;
+
+    std::memcpy(&header, data, sizeof(header));
+
+    if (std::memcmp(header.magic, g_magic, sizeof(g_magic)) || header.version != g_version)
+        return nullptr;
+
+    if (header.tocOffset > size || header.numEntries > (size - header.tocOffset) / sizeof(Entry))
+        return nullptr;
+
+    // The names end with a terminator, so that none of them can run off the end
+    if (header.namesOffset > size || header.namesSize > size - header.namesOffset
+    || (header.namesSize && data[header.namesOffset + header.namesSize - 1]))
+        return nullptr;
+
+    rcptr<Archive> archive = new Archive;
+
+    archive->m_file  = std::make_shared<rcptr<IFileReader>>(memory);
+    archive->m_data  = data;
+    archive->m_names = reinterpret_cast<const char*>(data + header.namesOffset);
+    archive->m_entries.resize(header.numEntries);
+
+    if (header.numEntries)
+        std::memcpy(&archive->m_entries[0], data + header.tocOffset, header.numEntries * sizeof(Entry));
+
+    for (auto it = archive->m_entries.begin(); it != archive->m_entries.end(); ++it)
+    {
+        if (it->nameOffset >= header.namesSize || it->offset > size || it->packedSize > size - it->offset)
+            return nullptr;
+
+        if (!(it->flags & Compressed) && it->packedSize != it->size)
+            return nullptr;
+
+        if (it->size > g_maxEntrySize || it->size > it->packedSize * g_maxLz4Ratio)
+            return nullptr;
+    }
+
+    return archive;
+}
+
+rcptr<IFileReader> Archive::openReader(const char* filename)
+{
+    auto index = _find(filename);
+    if (index < 0)
+        return nullptr;
+
+    auto& entry = m_entries[index];
+    auto  data  = m_data + entry.offset;
+
+    if (!(entry.flags & Compressed))
+        return new MemoryReader(filename, data, (std::size_t) entry.size, new DataRef(m_file));
+
+    std::vector<byte> buffer((std::size_t) entry.size);
+
+    if (!buffer.empty() && !Lz4::decompress(data, (std::size_t) entry.packedSize, &buffer[0], buffer.size()))
+        return nullptr;
+
+    return new MemoryReader(filename, buffer);
+}
+
+int Archive::_find(const char* filename) const
+{
+    auto hash = Name(filename).hash();
+
+    auto less = [] (const Entry& entry, uint64 value) { return entry.hash < value; };
+    auto it   = std::lower_bound(m_entries.begin(), m_entries.end(), hash, less);
+
+    for (; it != m_entries.end() && it->hash == hash; ++it)
+        if (std::strcmp(m_names + it->nameOffset, filename) == 0)
+            return int(it - m_entries.begin());
+
+    return -1;
+}
+
+
+//////////////////////////////////////////////////////////////////////////
+// Writing
+
+void ArchiveBuilder::add(const char* filename, const void* data, std::size_t size, bool compress)
+{
+    Item item;
+
+    item.name       = filename;
+    item.size       = size;
+    item.compressed = false;
+
+    auto bytes = static_cast<const byte*>(data);
+
+    if (compress && size)
+    {
+        item.data.resize(Lz4::bound(size));
+        item.data.resize(Lz4::compress(data, size, &item.data[0]));
+
+        item.compressed = item.data.size() <= size - size / 8;
+    }
+
+    if (!item.compressed)
+        item.data.assign(bytes, bytes + size);
+
+    m_items.push_back(item);
+}
+
+bool ArchiveBuilder::write(IWriter* out) const
+{
+    Header header;
+    std::memcpy(header.magic, g_magic, sizeof(g_magic));
+
+    header.version    = g_version;
+    header.numEntries = (uint) m_items.size();
+    header.alignment  = m_alignment;
+
+    std::vector<Archive::Entry> entries(m_items.size());
+    std::string names;
+
+    uint64 offset = alignUp(sizeof(header), m_alignment);
+
+    for (std::size_t i = 0; i < m_items.size(); ++i)
+    {
+        auto& item  = m_items[i];
+        auto& entry = entries[i];
+
+        entry.hash       = Name(item.name).hash();
+        entry.offset     = offset;
+        entry.size       = item.size;
+        entry.packedSize = item.data.size();
+        entry.nameOffset = (uint) names.size();
+        entry.flags      = item.compressed ? Compressed : 0;
+
+        names.append(item.name.c_str(), item.name.size() + 1);
+        offset = alignUp(offset + entry.packedSize, m_alignment);
+    }
+
+    header.tocOffset   = offset;
+    header.namesOffset = offset + entries.size() * sizeof(Archive::Entry);
+    header.namesSize   = names.size();
+
+    if (out->write(header) != sizeof(header))
+        return false;
+
+    uint64 pos = sizeof(header);
+
+    for (std::size_t i = 0; i < m_items.size(); ++i)
+    {
+        auto& data = m_items[i].data;
+
+        if (!writePadding(out, entries[i].offset - pos))
+            return false;
+
+        if (!data.empty() && out->write(&data[0], data.size()) != data.size())
+            return false;
+
+        pos = entries[i].offset + data.size();
+    }
+
+    if (!writePadding(out, header.tocOffset - pos))
+        return false;
+
+    // Sorted by hash for lookup, after the offsets were assigned in order of addition
+    std::sort(entries.begin(), entries.end(),
+        [] (const Archive::Entry& a, const Archive::Entry& b) { return a.hash < b.hash; });
+
+    auto tocSize = entries.size() * sizeof(Archive::Entry);
+
+    if (!entries.empty() && out->write(&entries[0], entries.size()) != tocSize)
+        return false;
+
+    return out->write(names.data(), names.size()) == names.size();
+}
+
+} // ns io
+} // ns mcr
@@ -4,12 +4,16 @@
 #   define WIN32_LEAN_AND_MEAN
 #   define NOMINMAX
 #   include <Windows.h>
-#elif defined(MCR_PLATFORM_LINUX)
+#else
+#   include <sys/mman.h>
 #   include <sys/stat.h>
+#   include <fcntl.h>
+#   include <unistd.h>
 #   include <dirent.h>
 #endif
 
 #include <algorithm>
+#include <cstring>
 #include <fstream>
 
 namespace mcr {
@@ -48,7 +52,7 @@ std::string Path::format(const char* path)
     std::string result = path;
     std::transform(result.cbegin(), result.cend(), result.begin(), toPathChar);
 
-    if (result.back() == '/')
+    if (!result.empty() && result.back() == '/')
         result.erase(result.size() - 1);
 
     return result;
@@ -163,6 +167,11 @@ public:
         return m_filename.c_str();
     }
 
+    const void* data() const
+    {
+        return nullptr;
+    }
+
     bool good() const
     {
         return m_stream.good();
@@ -217,15 +226,200 @@ protected:
 } // ns
 
 
+//////////////////////////////////////////////////////////////////////////
+// Memory-mapped reader, used for binary files
+
+namespace {
+class MappedFileReader: public IFileReader
+{
+public:
+    using RefCounted::operator new;
+    using RefCounted::operator delete;
+
+    MappedFileReader(const char* filename):
+        m_filename(filename),
+        m_data(nullptr),
+        m_size(0u),
+        m_pos(0u)
+    {
+        _map();
+    }
+
+    ~MappedFileReader()
+    {
+        _unmap();
+    }
+
+    std::size_t read(void* buffer, std::size_t size)
+    {
+        auto bytes = (std::size_t) std::min<uint64>(size, m_size - m_pos);
+
+        std::memcpy(buffer, m_data + m_pos, bytes);
+        m_pos += bytes;
+
+        return bytes;
+    }
+
+    uint64 size() const
+    {
+        return m_size;
+    }
+
+    uint64 tell() const
+    {
+        return m_pos;
+    }
+
+    void seek(uint64 pos)
+    {
+        m_pos = std::min(pos, m_size);
+    }
+
+    const char* filename() const
+    {
+        return m_filename.c_str();
+    }
+
+    const void* data() const
+    {
+        return m_data;
+    }
+
+    bool good() const
+    {
+        return m_data != nullptr;
+    }
+
+private:
+#if defined(MCR_PLATFORM_WINDOWS)
+
+    void _map()
+    {
+        m_mapping = nullptr;
+        m_file = CreateFileA(m_filename.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr,
+                             OPEN_EXISTING, FILE_FLAG_SEQUENTIAL_SCAN, nullptr);
+
+        LARGE_INTEGER size;
+        if (m_file == INVALID_HANDLE_VALUE || !GetFileSizeEx(m_file, &size) || !size.QuadPart)
+            return;
+
+        if (!(m_mapping = CreateFileMappingA(m_file, nullptr, PAGE_READONLY, 0, 0, nullptr)))
+            return;
+
+        if ((m_data = static_cast<const byte*>(MapViewOfFile(m_mapping, FILE_MAP_READ, 0, 0, 0))))
+            m_size = (uint64) size.QuadPart;
+    }
+
+    void _unmap()
+    {
+        if (m_data)
+            UnmapViewOfFile(m_data);
+
+        if (m_mapping)
+            CloseHandle(m_mapping);
+
+        if (m_file != INVALID_HANDLE_VALUE)
+            CloseHandle(m_file);
+    }
+
+    HANDLE m_file, m_mapping;
+
+#else
+
+    void _map()
+    {
+        int fd = open(m_filename.c_str(), O_RDONLY);
+        if (fd < 0)
+            return;
+
+        struct stat st;
+        if (fstat(fd, &st) == 0 && S_ISREG(st.st_mode) && st.st_size > 0)
+        {
+            auto ptr = mmap(nullptr, (std::size_t) st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+            if (ptr != MAP_FAILED)
+            {
+                // Assets are consumed front to back, let the kernel read ahead
+                madvise(ptr, (std::size_t) st.st_size, MADV_SEQUENTIAL);
+                madvise(ptr, (std::size_t) st.st_size, MADV_WILLNEED);
+
+                m_data = static_cast<const byte*>(ptr);
+                m_size = (uint64) st.st_size;
+            }
+        }
+
+        close(fd); // the mapping keeps the file alive
+    }
+
+    void _unmap()
+    {
+        if (m_data)
+            munmap(const_cast<byte*>(m_data), (std::size_t) m_size);
+    }
+
+#endif
+
+    std::string m_filename;
+    const byte* m_data;
+    uint64 m_size, m_pos;
+};
+} // ns
+
+
 //////////////////////////////////////////////////////////////////////////
 // File search & access
 
+bool FileSystem::mount(const char* filename, bool overRoot)
+{
+    auto archive = Archive::open(openReader(filename));
+    if (!archive)
+        return false;
+
+    m_mounts.push_back(Mount(archive, overRoot));
+    return true;
+}
+
+void FileSystem::unmountAll()
+{
+    m_mounts.clear();
+}
+
+rcptr<IFileReader> FileSystem::_openFromArchives(const char* filename, bool overRoot)
+{
+    if (m_mounts.empty() || !*filename)
+        return nullptr;
+
+    auto name = Path::format(filename);
+
+    for (auto it = m_mounts.rbegin(); it != m_mounts.rend(); ++it)
+        if (it->second == overRoot)
+            if (auto file = it->first->openReader(name.c_str()))
+                return file;
+
+    return nullptr;
+}
+
 rcptr<IFileReader> FileSystem::openReader(const char* filename, bool binary)
 {
-    rcptr<StdFstreamReader> file = new StdFstreamReader((m_root + filename).c_str(), binary);
+    if (auto packed = _openFromArchives(filename, true))
+        return packed;
+
+    auto path = m_root + filename;
+
+    // Binary files are mapped when possible so that consumers can
+    // reach the bytes via IFileReader::data() without a copy;
+    // empty and special files fall back to the stream reader
+    if (binary)
+    {
+        rcptr<MappedFileReader> mapped = new MappedFileReader(path.c_str());
+
+        if (mapped->good())
+            return mapped;
+    }
+
+    rcptr<StdFstreamReader> file = new StdFstreamReader(path.c_str(), binary);
 
     if (!file->good())
-        return nullptr;
+        return _openFromArchives(filename, false);
 
     return file;
 }
@@ -0,0 +1,179 @@
+#include <mcr/io/Lz4.h>
+
+#include <cstring>
+#include <vector>
+
+namespace mcr {
+namespace io  {
+
+namespace {
+
+const std::size_t g_minMatch     = 4;
+const std::size_t g_lastLiterals = 5;  // the block has to end with literals
+const std::size_t g_matchLimit   = 12; // no match may start closer to the end
+const std::size_t g_maxOffset    = 65535;
+const int         g_hashBits     = 12;
+
+uint read32(const byte* ptr)
+{
+    uint value;
+    std::memcpy(&value, ptr, sizeof(value));
+    return value;
+}
+
+uint hashOf(uint sequence)
+{
+    return (sequence * 2654435761u) >> (32 - g_hashBits);
+}
+
+byte* writeLength(byte* op, std::size_t length)
+{
+    for (; length >= 255; length -= 255)
+        *op++ = 255;
+
+    *op++ = byte(length);
+    return op;
+}
+
+byte* writeSequence(byte* op, const byte* literals, std::size_t numLiterals, std::size_t offset, std::size_t matchLength)
+{
+    auto token = op++;
+
+    *token = byte((numLiterals < 15 ? numLiterals : 15) << 4);
+
+    if (numLiterals >= 15)
+        op = writeLength(op, numLiterals - 15);
+
+    std::memcpy(op, literals, numLiterals);
+    op += numLiterals;
+
+    if (!offset) // the last sequence, literals only
+        return op;
+
+    *op++ = byte(offset);
+    *op++ = byte(offset >> 8);
+
+    matchLength -= g_minMatch;
+    *token |= byte(matchLength < 15 ? matchLength : 15);
+
+    if (matchLength >= 15)
+        op = writeLength(op, matchLength - 15);
+
+    return op;
+}
+
+bool readLength(const byte*& ip, const byte* end, std::size_t& length)
+{
+    for (byte b = 255; b == 255; length += b)
+    {
+        if (ip >= end)
+            return false;
+
+        b = *ip++;
+    }
+
+    return true;
+}
+
+} // ns
+
+
+std::size_t Lz4::compress(const void* src, std::size_t size, void* dst)
+{
+    auto in     = static_cast<const byte*>(src);
+    auto end    = in + size;
+    auto ip     = in;
+    auto anchor = in;
+    auto op     = static_cast<byte*>(dst);
+
+    if (size > g_matchLimit)
+    {
+        std::vector<int> table(1 << g_hashBits, -1);
+
+        auto limit      = end - g_matchLimit;
+        auto matchLimit = end - g_lastLiterals;
+
+        while (ip < limit)
+        {
+            auto sequence = read32(ip);
+            auto& slot    = table[hashOf(sequence)];
+            auto ref      = slot;
+
+            slot = int(ip - in);
+
+            if (ref < 0 || std::size_t(ip - in - ref) > g_maxOffset || read32(in + ref) != sequence)
+            {
+                ++ip;
+                continue;
+            }
+
+            auto match = in + ref;
+            auto p     = ip + g_minMatch;
+
+            for (auto q = match + g_minMatch; p < matchLimit && *p == *q; ++p, ++q);
+
+            op = writeSequence(op, anchor, ip - anchor, ip - match, p - ip);
+            ip = anchor = p;
+        }
+    }
+
+    op = writeSequence(op, anchor, end - anchor, 0, 0);
+    return op - static_cast<byte*>(dst);
+}
+
+bool Lz4::decompress(const void* src, std::size_t size, void* dst, std::size_t dstSize)
+{
+    auto ip   = static_cast<const byte*>(src);
+    auto iend = ip + size;
+    auto out  = static_cast<byte*>(dst);
+    auto op   = out;
+    auto oend = out + dstSize;
+
+    while (ip < iend)
+    {
+        auto token = *ip++;
+
+        std::size_t numLiterals = token >> 4;
+
+        if (numLiterals == 15 && !readLength(ip, iend, numLiterals))
+            return false;
+
+        if (numLiterals > std::size_t(iend - ip) || numLiterals > std::size_t(oend - op))
+            return false;
+
+        std::memcpy(op, ip, numLiterals);
+        op += numLiterals;
+        ip += numLiterals;
+
+        if (ip == iend)
+            break;
+
+        if (iend - ip < 2)
+            return false;
+
+        std::size_t offset = ip[0] | (ip[1] << 8);
+        ip += 2;
+
+        if (!offset || offset > std::size_t(op - out))
+            return false;
+
+        std::size_t matchLength = token & 15;
+
+        if (matchLength == 15 && !readLength(ip, iend, matchLength))
+            return false;
+
+        matchLength += g_minMatch;
+
+        if (matchLength > std::size_t(oend - op))
+            return false;
+
+        // Byte by byte, as the match may overlap what it produces
+        for (auto match = op - offset; matchLength; --matchLength)
+            *op++ = *match++;
+    }
+
+    return op == oend;
+}
+
+} // ns io
+} // ns mcr
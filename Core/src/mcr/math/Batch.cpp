@@ -0,0 +1,237 @@
+#include <mcr/math/Batch.h>
+
+#include <condition_variable>
+#include <mutex>
+#include <mcr/ThreadPool.h>
+
+namespace mcr   {
+namespace math  {
+namespace batch {
+
+namespace {
+
+// Below this, handing work to other threads costs more than it saves
+const std::size_t MinChunkSize = 16 * 1024;
+
+// Calls fn(begin, end) over [0, n) split among the pool and the calling thread
+template <typename Fn>
+void parallelFor(std::size_t n, ThreadPool* pool, Fn fn)
+{
+    if (!pool || n < 2 * MinChunkSize)
+    {
+        fn(std::size_t(0), n);
+        return;
+    }
+
+    auto numChunks = std::min<std::size_t>(pool->numThreads() + 1, n / MinChunkSize);
+    auto chunkSize = ((n + numChunks - 1) / numChunks + 3) & ~std::size_t(3);
+
+    std::mutex mutex;
+    std::condition_variable done;
+    std::size_t numPending = 0;
+
+    for (auto begin = chunkSize; begin < n; begin += chunkSize)
+    {
+        auto end = std::min(begin + chunkSize, n);
+
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            ++numPending;
+        }
+
+        pool->enqueue([&, begin, end] ()
+        {
+            fn(begin, end);
+
+            std::lock_guard<std::mutex> lock(mutex);
+            if (!--numPending)
+                done.notify_one();
+        });
+    }
+
+    fn(std::size_t(0), std::min(chunkSize, n));
+
+    std::unique_lock<std::mutex> lock(mutex);
+    done.wait(lock, [&] { return !numPending; });
+}
+
+inline const float* components(const vec3* v) { return *v; }
+inline float*       components(vec3* v)       { return *v; }
+
+void transformRange(const vec3* in, vec3* out, std::size_t begin, std::size_t end, const mat4& m, bool points)
+{
+    auto i = begin;
+
+#ifdef MCR_MATH_SIMD
+    using namespace simd;
+
+    const float4
+        m0 = splat(m[0]), m1 = splat(m[1]), m2  = splat(m[ 2]),
+        m4 = splat(m[4]), m5 = splat(m[5]), m6  = splat(m[ 6]),
+        m8 = splat(m[8]), m9 = splat(m[9]), m10 = splat(m[10]),
+        tx = splat(points ? m[12] : 0.f),
+        ty = splat(points ? m[13] : 0.f),
+        tz = splat(points ? m[14] : 0.f);
+
+    for (; i + 4 <= end; i += 4)
+    {
+        float4 x, y, z;
+        load3(components(in + i), x, y, z);
+
+        store3(components(out + i),
+            madd(x, m0, madd(y, m4, madd(z, m8,  tx))),
+            madd(x, m1, madd(y, m5, madd(z, m9,  ty))),
+            madd(x, m2, madd(y, m6, madd(z, m10, tz))));
+    }
+#endif
+
+    for (; i < end; ++i)
+        out[i] = points ? in[i] * m + m.translation() : in[i] * m;
+}
+
+void normalizeRange(const vec3* in, vec3* out, std::size_t begin, std::size_t end)
+{
+    auto i = begin;
+
+#ifdef MCR_MATH_SIMD
+    using namespace simd;
+
+    const float4 minLengthSq = splat(std::numeric_limits<float>::epsilon() * std::numeric_limits<float>::epsilon());
+
+    for (; i + 4 <= end; i += 4)
+    {
+        float4 x, y, z;
+        load3(components(in + i), x, y, z);
+
+        float4 lengthSq = madd(x, x, madd(y, y, mul(z, z)));
+        float4 scale    = select(greater(lengthSq, minLengthSq), invSqrt(lengthSq), splat(1.f));
+
+        store3(components(out + i), mul(x, scale), mul(y, scale), mul(z, scale));
+    }
+#endif
+
+    for (; i < end; ++i)
+        out[i] = math::normalize(in[i]);
+}
+
+} // ns
+
+
+//////////////////////////////////////////////////////////////////////////
+// AoS
+
+void transformVectors(const vec3* in, vec3* out, std::size_t n, const mat4& m, ThreadPool* pool)
+{
+    parallelFor(n, pool, [&] (std::size_t begin, std::size_t end)
+    {
+        transformRange(in, out, begin, end, m, false);
+    });
+}
+
+void transformPoints(const vec3* in, vec3* out, std::size_t n, const mat4& m, ThreadPool* pool)
+{
+    parallelFor(n, pool, [&] (std::size_t begin, std::size_t end)
+    {
+        transformRange(in, out, begin, end, m, true);
+    });
+}
+
+void multiply(const mat4& lhs, const mat4* rhs, mat4* out, std::size_t n, ThreadPool* pool)
+{
+    parallelFor(n, pool, [&] (std::size_t begin, std::size_t end)
+    {
+        for (auto i = begin; i < end; ++i)
+            detail::multiply4x4(&lhs[0], &rhs[i][0], &out[i][0]);
+    });
+}
+
+void normalize(const vec3* in, vec3* out, std::size_t n, ThreadPool* pool)
+{
+    parallelFor(n, pool, [&] (std::size_t begin, std::size_t end)
+    {
+        normalizeRange(in, out, begin, end);
+    });
+}
+
+
+//////////////////////////////////////////////////////////////////////////
+// SoA
+
+void transformPoints(const float* x, const float* y, const float* z,
+                     float* outX, float* outY, float* outZ, std::size_t n,
+                     const mat4& m, ThreadPool* pool)
+{
+    parallelFor(n, pool, [&] (std::size_t begin, std::size_t end)
+    {
+        auto i = begin;
+
+#ifdef MCR_MATH_SIMD
+        using namespace simd;
+
+        const float4
+            m0 = splat(m[0]), m1 = splat(m[1]), m2  = splat(m[ 2]),
+            m4 = splat(m[4]), m5 = splat(m[5]), m6  = splat(m[ 6]),
+            m8 = splat(m[8]), m9 = splat(m[9]), m10 = splat(m[10]),
+            tx = splat(m[12]), ty = splat(m[13]), tz = splat(m[14]);
+
+        for (; i + 4 <= end; i += 4)
+        {
+            float4 vx = load(x + i), vy = load(y + i), vz = load(z + i);
+
+            store(outX + i, madd(vx, m0, madd(vy, m4, madd(vz, m8,  tx))));
+            store(outY + i, madd(vx, m1, madd(vy, m5, madd(vz, m9,  ty))));
+            store(outZ + i, madd(vx, m2, madd(vy, m6, madd(vz, m10, tz))));
+        }
+#endif
+
+        for (; i < end; ++i)
+        {
+            auto p = vec3(x[i], y[i], z[i]) * m + m.translation();
+
+            outX[i] = p.x();
+            outY[i] = p.y();
+            outZ[i] = p.z();
+        }
+    });
+}
+
+void normalize(const float* x, const float* y, const float* z,
+               float* outX, float* outY, float* outZ, std::size_t n,
+               ThreadPool* pool)
+{
+    parallelFor(n, pool, [&] (std::size_t begin, std::size_t end)
+    {
+        auto i = begin;
+
+#ifdef MCR_MATH_SIMD
+        using namespace simd;
+
+        const float4 minLengthSq = splat(std::numeric_limits<float>::epsilon() * std::numeric_limits<float>::epsilon());
+
+        for (; i + 4 <= end; i += 4)
+        {
+            float4 vx = load(x + i), vy = load(y + i), vz = load(z + i);
+
+            float4 lengthSq = madd(vx, vx, madd(vy, vy, mul(vz, vz)));
+            float4 scale    = select(greater(lengthSq, minLengthSq), invSqrt(lengthSq), splat(1.f));
+
+            store(outX + i, mul(vx, scale));
+            store(outY + i, mul(vy, scale));
+            store(outZ + i, mul(vz, scale));
+        }
+#endif
+
+        for (; i < end; ++i)
+        {
+            auto v = math::normalize(vec3(x[i], y[i], z[i]));
+
+            outX[i] = v.x();
+            outY[i] = v.y();
+            outZ[i] = v.z();
+        }
+    });
+}
+
+} // ns batch
+} // ns math
+} // ns mcr
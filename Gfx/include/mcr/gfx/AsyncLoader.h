@@ -0,0 +1,75 @@
+#pragma once
+
+#include <atomic>
+#include <deque>
+#include <functional>
+#include <future>
+#include <mutex>
+#include <condition_variable>
+#include <mcr/GfxExtern.h>
+#include <mcr/NonCopyable.h>
+#include <mcr/ThreadPool.h>
+#include <mcr/io/FileSystem.h>
+#include <mcr/gfx/geom/Mesh.h>
+#include <mcr/gfx/mtl/Texture.h>
+
+namespace mcr {
+namespace gfx {
+
+//! Two-stage loader: workers open, read and sanity-check files, while
+//! everything touching GL is left for pump() on the context thread
+class AsyncLoader: NonCopyable
+{
+public:
+    //! Becomes ready with the outcome once the upload stage has run
+    typedef std::shared_future<bool> Ticket;
+
+    //! Worker-side header check, must not touch GL
+    typedef bool (*CheckFn)(io::IFileReader* stream);
+
+    //! Context-side stage, gets a memory-backed stream
+    typedef std::function<bool(io::IFileReader* stream)> UploadFn;
+
+    MCR_GFX_EXTERN AsyncLoader(io::FileSystem* fs, uint numThreads = 0);
+    MCR_GFX_EXTERN ~AsyncLoader(); // inherit not
+
+    MCR_GFX_EXTERN Ticket   load(const char* filename, bool binary, CheckFn check, const UploadFn& upload);
+
+    MCR_GFX_EXTERN Ticket   loadMesh(
+        const char* filename,
+        geom::mem::IVideoMemory* vertMem,
+        geom::mem::IVideoMemory* idxMem,
+        geom::Mesh& meshOut);
+
+    MCR_GFX_EXTERN Ticket   loadTexture(const char* filename, mtl::Texture* texture);
+
+    //! Run ready upload stages until \c budgetMicroseconds run out (at least one
+    //! is run if any is ready, so the queue keeps moving); returns the number run
+    MCR_GFX_EXTERN uint     pump(int64 budgetMicroseconds);
+
+    //! Block until everything queued so far is loaded
+    MCR_GFX_EXTERN void     finish();
+
+    std::size_t             numPending() const;
+    io::FileSystem*         fs() const;
+
+private:
+    struct Job;
+
+    MCR_GFX_INTERN void     _read(Job* job);
+    MCR_GFX_INTERN Job*     _popReady();
+
+    io::FileSystem*         m_fs;
+
+    std::deque<Job*>        m_ready;
+    std::mutex              m_readyMutex;
+    std::condition_variable m_readyAdded;
+    std::atomic<std::size_t> m_numPending;
+
+    ThreadPool              m_pool; // last, so workers are gone before the rest
+};
+
+} // ns gfx
+} // ns mcr
+
+#include "AsyncLoader.inl"
@@ -0,0 +1,15 @@
+namespace mcr {
+namespace gfx {
+
+inline std::size_t AsyncLoader::numPending() const
+{
+    return m_numPending;
+}
+
+inline io::FileSystem* AsyncLoader::fs() const
+{
+    return m_fs;
+}
+
+} // ns gfx
+} // ns mcr
@@ -1,6 +1,6 @@
 #pragma once
 
-#include <mcr/math/Matrix.h>
+#include <mcr/math/Frustum.h>
 #include <mcr/gfx/mtl/ParamBuffer.h>
 
 namespace mcr {
@@ -24,6 +24,9 @@ public:
     const mat4&         modelViewMatrix() const;
     const mat4&         modelViewProjMatrix() const;
 
+    //! In world space, i.e. that of projection * view
+    frustum             viewFrustum() const;
+
     const vec3&         position() const;
     void                setPosition(const vec3& pos);
 
@@ -48,6 +48,11 @@ inline const mat4& Camera::modelViewProjMatrix() const
     return m_mvp.first;
 }
 
+inline frustum Camera::viewFrustum() const
+{
+    return frustum(m_projection.first * m_view);
+}
+
 inline const vec3& Camera::position() const
 {
     return m_position;
@@ -0,0 +1,54 @@
+#pragma once
+
+#include <vector>
+#include <mcr/GfxExtern.h>
+#include <mcr/NonCopyable.h>
+#include <mcr/math/Frustum.h>
+
+namespace mcr {
+namespace gfx {
+
+//! Tests many boxes against a frustum at once. Bounds are stored as
+//! separate arrays of centers and extents, so four boxes go through
+//! each plane test together when SSE is around.
+class Culler: NonCopyable
+{
+public:
+    MCR_GFX_EXTERN Culler();
+    MCR_GFX_EXTERN ~Culler(); // inherit not
+
+    //! Returns the box's index; an empty box stands for unknown bounds and is never culled
+    MCR_GFX_EXTERN uint add(const bbox& box);
+
+    //! Appends the indices of the boxes intersecting \c view, in order
+    MCR_GFX_EXTERN void cull(const frustum& view, std::vector<uint>& visibleOut) const;
+
+    std::size_t         size() const;
+    void                clear();
+
+private:
+    // Padded to a multiple of four
+    std::vector<float>  m_centers[3];
+    std::vector<float>  m_extents[3];
+    std::size_t         m_size;
+};
+
+
+inline std::size_t Culler::size() const
+{
+    return m_size;
+}
+
+inline void Culler::clear()
+{
+    for (int i = 0; i < 3; ++i)
+    {
+        m_centers[i].clear();
+        m_extents[i].clear();
+    }
+
+    m_size = 0;
+}
+
+} // ns gfx
+} // ns mcr
@@ -0,0 +1,69 @@
+#pragma once
+
+#include <vector>
+#include <mcr/GfxExtern.h>
+#include <mcr/NonCopyable.h>
+#include <mcr/Profiler.h>
+
+namespace mcr {
+namespace gfx {
+
+//! GPU zones measured with timestamp queries and passed on to the Profiler,
+//! on a "GPU" track of their own. A frame's queries are read Latency frames
+//! later, by which time they're long done, so profiling never stalls the
+//! pipeline; those still pending even then are dropped.
+class GpuProfiler: NonCopyable
+{
+public:
+    enum { Latency = 3 };
+
+    MCR_GFX_EXTERN static GpuProfiler& instance();
+
+    //! Start a zone; returns -1 and does nothing while the Profiler is
+    //! disabled or if the driver has no timer queries
+    MCR_GFX_EXTERN int  begin(const char* name);
+    MCR_GFX_EXTERN void end(int zone);
+
+    //! Collect the zones from Latency frames ago; Renderer::endFrame() calls it
+    MCR_GFX_EXTERN void endFrame();
+
+private:
+    struct Zone
+    {
+        const char* name;
+        uint        queries[2];
+    };
+
+    GpuProfiler();
+
+    MCR_GFX_INTERN void _collect(std::vector<Zone>& zones);
+    MCR_GFX_INTERN uint _query();
+
+    std::vector<Zone>   m_frames[Latency + 1];
+    uint                m_frame;
+    std::vector<uint>   m_freeQueries;
+    Profiler::Track*    m_track;
+};
+
+//! Times the GPU work issued from construction to destruction
+class GpuProfileScope: NonCopyable
+{
+public:
+    explicit GpuProfileScope(const char* name): m_zone(GpuProfiler::instance().begin(name)) {}
+    ~GpuProfileScope() { GpuProfiler::instance().end(m_zone); }
+
+private:
+    int m_zone;
+};
+
+} // ns gfx
+} // ns mcr
+
+//! Profile the GPU work of the rest of the enclosing scope as \c name;
+//! compiled out with MCR_NO_PROFILE
+#if defined(MCR_NO_PROFILE)
+#   define MCR_GPU_PROFILE_SCOPE(name)
+#else
+#   define MCR_GPU_PROFILE_SCOPE(name) \
+        ::mcr::gfx::GpuProfileScope MCR_PROFILE_CONCAT(mcrGpuProfileScope, __LINE__)(name)
+#endif
@@ -0,0 +1,54 @@
+#pragma once
+
+#include <mcr/GfxExtern.h>
+#include <mcr/NonCopyable.h>
+#include <mcr/math/Vector.h>
+
+namespace mcr {
+namespace gfx {
+
+//! A GL context with no window, for machines without a display. It's made
+//! through EGL, surfaceless where supported and on a tiny pbuffer otherwise,
+//! and renders into a framebuffer object that stays bound as the default target.
+class HeadlessContext: NonCopyable
+{
+public:
+    MCR_GFX_EXTERN HeadlessContext();
+    MCR_GFX_EXTERN ~HeadlessContext(); // inherit not
+
+    //! Create the context, make it current and set up the render target;
+    //! false if there's no EGL, no display or no GL 3.2+ context to be had
+    MCR_GFX_EXTERN bool     create(const ivec2& size);
+    MCR_GFX_EXTERN void     destroy();
+
+    MCR_GFX_EXTERN bool     makeCurrent();
+
+    //! Reallocate the render target, its contents are lost, and set the
+    //! viewport to cover it
+    MCR_GFX_EXTERN void     resize(const ivec2& size);
+
+    //! Block until all commands issued so far have executed; there are no
+    //! buffer swaps to pace the frames otherwise
+    MCR_GFX_EXTERN void     finish();
+
+    bool                    isValid() const;
+    const ivec2&            size() const;
+    uint                    framebuffer() const;
+
+private:
+    MCR_GFX_INTERN void     _createFramebuffer();
+    MCR_GFX_INTERN void     _destroyFramebuffer();
+
+    void*   m_display;
+    void*   m_context;
+    void*   m_surface;
+
+    ivec2   m_size;
+    uint    m_framebuffer;
+    uint    m_colorBuffer, m_depthBuffer;
+};
+
+} // ns gfx
+} // ns mcr
+
+#include "HeadlessContext.inl"
@@ -0,0 +1,20 @@
+namespace mcr {
+namespace gfx {
+
+inline bool HeadlessContext::isValid() const
+{
+    return m_context != nullptr;
+}
+
+inline const ivec2& HeadlessContext::size() const
+{
+    return m_size;
+}
+
+inline uint HeadlessContext::framebuffer() const
+{
+    return m_framebuffer;
+}
+
+} // ns gfx
+} // ns mcr
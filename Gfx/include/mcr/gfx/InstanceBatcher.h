@@ -0,0 +1,80 @@
+#pragma once
+
+#include <map>
+#include <tuple>
+#include <vector>
+#include <mcr/NonCopyable.h>
+#include <mcr/math/Matrix.h>
+#include <mcr/gfx/Renderer.h>
+
+namespace mcr {
+namespace gfx {
+
+//! Gathers copies of the same mesh with the same material and draws each
+//! such group with a single instanced call. The instance transform is a
+//! mat4 attribute (four locations) right after the mesh's attributes,
+//! laid out like the matrices uploaded as uniforms.
+class InstanceBatcher: NonCopyable
+{
+public:
+    struct Stats
+    {
+        uint numBatches;
+        uint numInstances;
+    };
+
+    //! Instance data is allocated from \c memory, which is best a StreamMemory
+    MCR_GFX_EXTERN explicit InstanceBatcher(geom::mem::IVideoMemory* memory);
+    MCR_GFX_EXTERN ~InstanceBatcher(); // inherit not
+
+    //! \c mesh must stay alive until flush()
+    MCR_GFX_EXTERN void add(mtl::Material* material, const geom::Mesh& mesh, const mat4& transform);
+
+    //! Draw all batches and start over; instance buffers are kept for reuse
+    //! by the next frame, those of batches it doesn't add to are dropped then
+    MCR_GFX_EXTERN void flush(Renderer& renderer);
+
+    //! Drop the batches along with their buffers
+    void                clear();
+
+    const geom::VertexFormat& instanceFormat() const;
+
+    //! Of the last flush
+    const Stats&        stats() const;
+
+private:
+    typedef std::tuple<mtl::Material*, const geom::mem::IVideoBuffer*, const geom::mem::IVideoBuffer*> Key;
+
+    struct Batch
+    {
+        const geom::Mesh*   mesh;
+        std::vector<mat4>   transforms;
+
+        rcptr<geom::mem::IVideoBuffer> buffer;
+    };
+
+    geom::mem::IVideoMemory*    m_memory;
+    geom::VertexFormat          m_instanceFormat;
+
+    std::map<Key, Batch>        m_batches;
+    Stats                       m_stats;
+};
+
+
+inline void InstanceBatcher::clear()
+{
+    m_batches.clear();
+}
+
+inline const geom::VertexFormat& InstanceBatcher::instanceFormat() const
+{
+    return m_instanceFormat;
+}
+
+inline const InstanceBatcher::Stats& InstanceBatcher::stats() const
+{
+    return m_stats;
+}
+
+} // ns gfx
+} // ns mcr
@@ -0,0 +1,96 @@
+#pragma once
+
+#include <vector>
+#include <mcr/NonCopyable.h>
+#include <mcr/math/Matrix.h>
+#include <mcr/gfx/Culler.h>
+#include <mcr/gfx/Renderer.h>
+
+namespace mcr {
+namespace gfx {
+
+//! Collects draws for a frame and issues them sorted by a 64-bit key, so
+//! that program, texture, buffer and render state changes are clustered.
+//! Within a pass, opaque draws go front to back, ordered by state first;
+//! blended ones go back to front regardless of state.
+//!
+//! The transform goes to the material's "Model" parameter, if it has one.
+//! Once a frustum is set, submissions whose bounds lie outside it are
+//! dropped on flush.
+class RenderQueue: NonCopyable
+{
+public:
+    struct Switches
+    {
+        uint materials;
+        uint programs;
+        uint textures;
+        uint buffers;
+        uint renderStates;
+    };
+
+    struct Stats
+    {
+        uint numDraws;
+        uint numCulled;
+
+        Switches issued;
+        Switches avoided;   //!< Compared to issuing in submission order
+    };
+
+    MCR_GFX_EXTERN RenderQueue();
+    MCR_GFX_EXTERN ~RenderQueue(); // inherit not
+
+    //! Where depth is measured from
+    void                setEye(const vec3& position);
+
+    //! What to cull against, in world space; see Camera::viewFrustum()
+    void                setFrustum(const frustum& view);
+    void                disableCulling();
+
+    //! \c mesh must stay alive until flush(); a negative \c passHint means the material's
+    MCR_GFX_EXTERN void submit(
+        mtl::Material* material,
+        const geom::Mesh& mesh,
+        const mat4& transform = mat4(),
+        int passHint = -1);
+
+    //! Sort and draw everything submitted so far, then empty the queue
+    MCR_GFX_EXTERN void flush(Renderer& renderer);
+
+    std::size_t         size() const;
+    void                clear();
+
+    //! Accumulated over flushes until reset
+    const Stats&        stats() const;
+    void                resetStats();
+
+private:
+    struct Item
+    {
+        uint64              key;
+        mtl::Material*      material;
+        const geom::Mesh*   mesh;
+        mat4                transform;
+        bbox                bounds;     //!< World space
+        int                 modelParam;
+    };
+
+    MCR_GFX_INTERN static void _countSwitches(const std::vector<Item*>& order, Switches& switchesOut);
+
+    std::vector<Item>   m_items;
+    std::vector<Item*>  m_order;
+    std::vector<const geom::Mesh*> m_batch; // a run of items drawn together
+    vec3                m_eye;
+    Stats               m_stats;
+
+    frustum             m_frustum;
+    bool                m_culling;
+    Culler              m_culler;
+    std::vector<uint>   m_visible;
+};
+
+} // ns gfx
+} // ns mcr
+
+#include "RenderQueue.inl"
@@ -0,0 +1,41 @@
+namespace mcr {
+namespace gfx {
+
+inline void RenderQueue::setEye(const vec3& position)
+{
+    m_eye = position;
+}
+
+inline void RenderQueue::setFrustum(const frustum& view)
+{
+    m_frustum = view;
+    m_culling = true;
+}
+
+inline void RenderQueue::disableCulling()
+{
+    m_culling = false;
+}
+
+inline std::size_t RenderQueue::size() const
+{
+    return m_items.size();
+}
+
+inline void RenderQueue::clear()
+{
+    m_items.clear();
+}
+
+inline const RenderQueue::Stats& RenderQueue::stats() const
+{
+    return m_stats;
+}
+
+inline void RenderQueue::resetStats()
+{
+    m_stats = Stats();
+}
+
+} // ns gfx
+} // ns mcr
@@ -0,0 +1,33 @@
+#pragma once
+
+#include <mcr/Types.h>
+
+namespace mcr {
+namespace gfx {
+
+//! GL work done over a frame, counted as it's issued. Binds already in place
+//! are filtered out by the state cache and counted as skipped instead.
+struct RenderStats
+{
+    struct Binds
+    {
+        uint programs;
+        uint textures;
+        uint buffers;
+        uint vertexArrays;
+    };
+
+    uint   numDraws;
+    uint64 numTriangles;
+
+    Binds  issued;
+    Binds  skipped;
+
+    uint   renderStateChanges;  //!< GL calls made switching between render states
+    uint   numUniforms;         //!< Plain uniforms uploaded, parameter buffers aside
+    uint64 paramBytes;          //!< Parameter buffer contents synced
+    uint64 bufferBytes;         //!< Written to video buffers or mapped for writing, streamed parameter buffers included
+};
+
+} // ns gfx
+} // ns mcr
@@ -1,6 +1,8 @@
 #pragma once
 
+#include <vector>
 #include <mcr/math/Rect.h>
+#include <mcr/gfx/RenderStats.h>
 #include <mcr/gfx/mtl/Material.h>
 #include <mcr/gfx/geom/Mesh.h>
 
@@ -24,8 +26,30 @@ public:
 
     MCR_GFX_EXTERN void         drawMesh(const geom::Mesh& mesh);
 
+    //! Per-instance attributes described by \c instanceFormat are read from
+    //! \c instances and take the locations right after the mesh's own
+    MCR_GFX_EXTERN void         drawMeshInstanced(
+                                    const geom::Mesh& mesh,
+                                    const geom::VertexFormat& instanceFormat,
+                                    const geom::mem::IVideoBuffer* instances,
+                                    uint numInstances);
+
+    //! Draws meshes sharing a vertex format in as few calls as possible:
+    //! those packed in the same vertex and index buffers go out in one
+    //! multi-draw, indirect when ARB_multi_draw_indirect is supported.
+    //! Returns the number of draw calls issued. Draws are regrouped, so their
+    //! order isn't kept; no good for blended meshes.
+    MCR_GFX_EXTERN uint         drawMeshBatch(const std::vector<const geom::Mesh*>& meshes);
+
     MCR_GFX_EXTERN void         clear();
 
+    //! Call once all of the frame's commands are issued; lets stream memory recycle
+    MCR_GFX_EXTERN void         endFrame();
+
+    //! What the last frame finished with endFrame() issued, across all
+    //! renderers and everything else touching the context
+    const RenderStats&          frameStats() const;
+
     MCR_GFX_EXTERN void         readFrontBuffer(const irect& area, vec4* pixelsOut)const;
     MCR_GFX_EXTERN void         readFrontBuffer(const irect& area, u8vec4* pixelsOut) const;
     MCR_GFX_EXTERN void         readFrontBuffer(const irect& area, u16vec4* pixelsOut) const;
@@ -36,6 +60,25 @@ protected:
     uint                m_renderStateHash;
 
     mtl::Material*      m_activeMaterial;
+
+    RenderStats         m_frameStats;
+
+private:
+    struct DrawCommand
+    {
+        uint count, instanceCount, firstIndex;
+        int  baseVertex;
+        uint baseInstance;
+    };
+
+    MCR_GFX_INTERN void _multiDraw(const std::vector<const geom::Mesh*>& meshes, std::size_t begin, std::size_t end);
+
+    std::vector<const geom::Mesh*>      m_batch;
+    std::vector<DrawCommand>            m_commands;
+
+    // One per multi-draw this frame, each written once per frame
+    std::vector<rcptr<geom::mem::IVideoBuffer>> m_commandBuffers;
+    std::size_t                         m_numCommandBuffers;
 };
 
 } // ns gfx
@@ -11,5 +11,10 @@ inline mtl::Material* Renderer::activeMaterial() const
     return m_activeMaterial;
 }
 
+inline const RenderStats& Renderer::frameStats() const
+{
+    return m_frameStats;
+}
+
 } // ns gfx
 } // ns mcr
@@ -3,6 +3,7 @@
 #include <mcr/GfxExtern.h>
 #include <mcr/io/IFileReader.h>
 #include <mcr/io/IWriter.h>
+#include <mcr/math/Sphere.h>
 #include <mcr/gfx/geom/VertexFormat.h>
 #include <mcr/gfx/geom/mem/IVideoMemory.h>
 
@@ -36,6 +37,11 @@ struct Mesh
 
     rcptr<mem::IVideoBuffer> vertices, indices;
 
+    //! In model space, computed on load from the first attribute if it holds
+    //! float positions; left empty otherwise, which means unknown
+    bbox   bounds;
+    sphere boundingSphere;
+
     uint numVertices() const;
     uint numIndices() const;
 
@@ -45,6 +51,9 @@ struct Mesh
         mem::IVideoMemory* idxMem,
         Mesh& meshOut);
 
+    //! Header sanity check that leaves GL alone, so any thread may call it
+    MCR_GFX_EXTERN static bool check(io::IFileReader* stream);
+
     MCR_GFX_EXTERN static bool save(
         io::IWriter* stream,
         const Mesh& mesh);
@@ -1,7 +1,9 @@
 #pragma once
 
+#include <mcr/gfx/AsyncLoader.h>
 #include <mcr/gfx/geom/Mesh.h>
-#include <mcr/gfx/geom/mem/NaiveMemory.h>
+#include <mcr/gfx/geom/mem/PooledMemory.h>
+#include <mcr/gfx/geom/mem/StreamMemory.h>
 
 namespace mcr  {
 namespace gfx  {
@@ -15,25 +17,31 @@ public:
     bool loadDynamic(io::IFileReader* stream, Mesh& meshOut);
     bool loadStatic(io::IFileReader* stream, Mesh& meshOut);
 
-    mem::NaiveMemory& dynamicVertexMem();
-    mem::NaiveMemory& dynamicIndexMem();
-    mem::NaiveMemory& staticVertexMem();
-    mem::NaiveMemory& staticIndexMem();
+    //! \c meshOut must stay put until the ticket is ready
+    AsyncLoader::Ticket loadDynamicAsync(AsyncLoader& loader, const char* filename, Mesh& meshOut);
+    AsyncLoader::Ticket loadStaticAsync(AsyncLoader& loader, const char* filename, Mesh& meshOut);
+
+    mem::StreamMemory& dynamicVertexMem();
+    mem::StreamMemory& dynamicIndexMem();
+    mem::PooledMemory& staticVertexMem();
+    mem::PooledMemory& staticIndexMem();
 
 private:
-    mem::NaiveMemory
+    mem::StreamMemory
         m_dynamicVertices,
-        m_dynamicIndices,
+        m_dynamicIndices;
+
+    mem::PooledMemory
         m_staticVertices,
         m_staticIndices;
 };
 
 
 inline MeshManager::MeshManager():
-    m_dynamicVertices(mem::NaiveMemory::Vertex, mem::NaiveMemory::Dynamic),
-    m_dynamicIndices (mem::NaiveMemory::Index,  mem::NaiveMemory::Dynamic),
-    m_staticVertices (mem::NaiveMemory::Vertex, mem::NaiveMemory::Static),
-    m_staticIndices  (mem::NaiveMemory::Index,  mem::NaiveMemory::Static) {}
+    m_dynamicVertices(mem::StreamMemory::Vertex),
+    m_dynamicIndices (mem::StreamMemory::Index),
+    m_staticVertices (mem::PooledMemory::Vertex, mem::PooledMemory::Static),
+    m_staticIndices  (mem::PooledMemory::Index,  mem::PooledMemory::Static) {}
 
 inline bool MeshManager::loadDynamic(io::IFileReader* stream, Mesh& meshOut)
 {
@@ -45,22 +53,32 @@ inline bool MeshManager::loadStatic(io::IFileReader* stream, Mesh& meshOut)
     return Mesh::load(stream, &m_staticVertices, &m_staticIndices, meshOut);
 }
 
-inline mem::NaiveMemory& MeshManager::dynamicVertexMem()
+inline AsyncLoader::Ticket MeshManager::loadDynamicAsync(AsyncLoader& loader, const char* filename, Mesh& meshOut)
+{
+    return loader.loadMesh(filename, &m_dynamicVertices, &m_dynamicIndices, meshOut);
+}
+
+inline AsyncLoader::Ticket MeshManager::loadStaticAsync(AsyncLoader& loader, const char* filename, Mesh& meshOut)
+{
+    return loader.loadMesh(filename, &m_staticVertices, &m_staticIndices, meshOut);
+}
+
+inline mem::StreamMemory& MeshManager::dynamicVertexMem()
 {
     return m_dynamicVertices;
 }
 
-inline mem::NaiveMemory& MeshManager::dynamicIndexMem()
+inline mem::StreamMemory& MeshManager::dynamicIndexMem()
 {
     return m_dynamicIndices;
 }
 
-inline mem::NaiveMemory& MeshManager::staticVertexMem()
+inline mem::PooledMemory& MeshManager::staticVertexMem()
 {
     return m_staticVertices;
 }
 
-inline mem::NaiveMemory& MeshManager::staticIndexMem()
+inline mem::PooledMemory& MeshManager::staticIndexMem()
 {
     return m_staticIndices;
 }
@@ -53,6 +53,9 @@ public:
 
     uint stride() const;
 
+    //! Covers the layout only, semantics don't count
+    uint64 hash() const;
+
     void clear();
 
     MCR_GFX_EXTERN std::string toString() const;
@@ -62,6 +65,9 @@ protected:
     uint m_stride;
 };
 
+bool operator==(const VertexFormat& lhs, const VertexFormat& rhs);
+bool operator!=(const VertexFormat& lhs, const VertexFormat& rhs);
+
 } // ns geom
 } // ns gfx
 } // ns mcr
@@ -59,12 +59,53 @@ inline uint VertexFormat::stride() const
     return m_stride;
 }
 
+inline uint64 VertexFormat::hash() const
+{
+    // FNV-1a over the layout
+    uint64 hash = 14695981039346656037ull;
+
+    auto mix = [&hash] (uint64 value)
+    {
+        hash = (hash ^ value) * 1099511628211ull;
+    };
+
+    mix(m_stride);
+
+    for (auto it = m_attribs.begin(); it != m_attribs.end(); ++it)
+        mix(uint64(it->type) | (uint64(it->length) << 8) | (uint64(it->offset) << 16));
+
+    return hash;
+}
+
 inline void VertexFormat::clear()
 {
     m_attribs.clear();
     m_stride = 0;
 }
 
+
+inline bool operator==(const VertexFormat& lhs, const VertexFormat& rhs)
+{
+    if (lhs.stride() != rhs.stride() || lhs.numAttribs() != rhs.numAttribs())
+        return false;
+
+    for (uint i = 0; i < lhs.numAttribs(); ++i)
+    {
+        auto& a = lhs.attrib(i);
+        auto& b = rhs.attrib(i);
+
+        if (a.type != b.type || a.length != b.length || a.offset != b.offset)
+            return false;
+    }
+
+    return true;
+}
+
+inline bool operator!=(const VertexFormat& lhs, const VertexFormat& rhs)
+{
+    return !(lhs == rhs);
+}
+
 } // ns geom
 } // ns gfx
 } // ns mcr
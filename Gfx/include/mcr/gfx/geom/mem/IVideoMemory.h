@@ -13,6 +13,10 @@ public:
     virtual void        read(std::size_t offset, std::size_t length, void* dst) const = 0;
     virtual void        write(std::size_t offset, std::size_t length, const void* src) = 0;
 
+    // Direct write access; map() may return nullptr if the buffer can't be mapped
+    virtual void*       map(std::size_t offset, std::size_t length) = 0;
+    virtual bool        unmap() = 0;
+
     virtual std::size_t size() const = 0;
 
     virtual uint        vbo() const = 0;
@@ -23,7 +27,10 @@ class IVideoMemory
 {
 public:
     virtual ~IVideoMemory() {}
-    virtual rcptr<IVideoBuffer> allocate(std::size_t size) = 0;
+
+    // offset() of the result is a multiple of \c alignment, which needn't be a power of two
+    // (e.g. vertex stride, so that the buffer can be drawn from with a base vertex)
+    virtual rcptr<IVideoBuffer> allocate(std::size_t size, std::size_t alignment = 1) = 0;
 };
 
 } // ns mem
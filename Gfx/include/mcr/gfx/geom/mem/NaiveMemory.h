@@ -23,6 +23,9 @@ public:
         MCR_GFX_EXTERN void read(std::size_t offset, std::size_t length, void* dst) const;
         MCR_GFX_EXTERN void write(std::size_t offset, std::size_t length, const void* src);
 
+        MCR_GFX_EXTERN void* map(std::size_t offset, std::size_t length);
+        MCR_GFX_EXTERN bool  unmap();
+
         std::size_t size() const { return m_size; }
 
         uint        vbo() const { return m_vbo; }
@@ -39,7 +42,7 @@ public:
 
     MCR_GFX_EXTERN NaiveMemory(Target target, Usage usage);
 
-    MCR_GFX_EXTERN rcptr<IVideoBuffer> allocate(std::size_t size);
+    MCR_GFX_EXTERN rcptr<IVideoBuffer> allocate(std::size_t size, std::size_t alignment = 1);
 
 private:
     friend class Buffer;
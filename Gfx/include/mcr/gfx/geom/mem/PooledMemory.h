@@ -0,0 +1,140 @@
+#pragma once
+
+#include <map>
+#include <vector>
+#include <mcr/GfxExtern.h>
+#include <mcr/NonCopyable.h>
+#include <mcr/gfx/geom/mem/IVideoMemory.h>
+
+namespace mcr  {
+namespace gfx  {
+namespace geom {
+namespace mem  {
+
+//! Carves allocations out of a few large GL buffers (pages) with a first-fit
+//! free list, so that lots of small meshes end up sharing one VBO. Buffers
+//! must be released before the memory they came from.
+//!
+//! Sizes are rounded up to Alignment within the pages, though buffers report
+//! the size asked for; offsets are aligned too, unless allocate() is given an
+//! alignment of its own.
+class PooledMemory: public IVideoMemory, NonCopyable
+{
+    struct Page;
+
+public:
+    class Buffer: public IVideoBuffer
+    {
+    public:
+        using RefCounted::operator new;
+        using RefCounted::operator delete;
+
+        MCR_GFX_EXTERN Buffer(PooledMemory* memory, Page* page, std::size_t offset, std::size_t size);
+        MCR_GFX_EXTERN ~Buffer();
+
+        MCR_GFX_EXTERN void read(std::size_t offset, std::size_t length, void* dst) const;
+        MCR_GFX_EXTERN void write(std::size_t offset, std::size_t length, const void* src);
+
+        MCR_GFX_EXTERN void* map(std::size_t offset, std::size_t length);
+        MCR_GFX_EXTERN bool  unmap();
+
+        std::size_t size() const;
+
+        uint        vbo() const;
+        const void* offset() const;
+
+    private:
+        PooledMemory* m_memory;
+        Page*       m_page;
+        std::size_t m_offset, m_size;
+    };
+
+    struct Stats
+    {
+        std::size_t numPages;
+        std::size_t numAllocations;
+        std::size_t bytesReserved;      //!< Total size of all pages
+        std::size_t bytesUsed;          //!< Handed out, sizes rounded up to Alignment
+        std::size_t numFreeBlocks;      //!< Gaps skipped to align an allocation included
+        std::size_t largestFreeBlock;
+
+        std::size_t bytesFree() const;
+
+        //! 0 if all the free space is in one block, approaching 1 as it gets scattered
+        float       fragmentation() const;
+    };
+
+    enum Target {Vertex, Index};
+    enum Usage {Static, Dynamic};
+
+    enum
+    {
+        DefaultPageSize = 4 << 20,
+        Alignment       = 16
+    };
+
+    MCR_GFX_EXTERN PooledMemory(Target target, Usage usage, std::size_t pageSize = DefaultPageSize);
+    MCR_GFX_EXTERN ~PooledMemory(); // inherit not
+
+    MCR_GFX_EXTERN rcptr<IVideoBuffer> allocate(std::size_t size, std::size_t alignment = 1);
+
+    MCR_GFX_EXTERN Stats    stats() const;
+    std::size_t             pageSize() const;
+
+private:
+    friend class Buffer;
+
+    struct Page
+    {
+        uint vbo;
+        std::size_t size;
+        std::size_t numAllocations;
+
+        //! Free blocks, offset to size; neighbours are always merged
+        std::map<std::size_t, std::size_t> freeBlocks;
+    };
+
+    MCR_GFX_INTERN Page*    _createPage(std::size_t size);
+    MCR_GFX_INTERN void     _release(Page* page, std::size_t offset, std::size_t size);
+
+    uint m_target, m_usage;
+    std::size_t m_pageSize;
+
+    std::vector<Page*> m_pages;
+};
+
+
+inline std::size_t PooledMemory::Buffer::size() const
+{
+    return m_size;
+}
+
+inline uint PooledMemory::Buffer::vbo() const
+{
+    return m_page->vbo;
+}
+
+inline const void* PooledMemory::Buffer::offset() const
+{
+    return reinterpret_cast<const void*>(m_offset);
+}
+
+inline std::size_t PooledMemory::Stats::bytesFree() const
+{
+    return bytesReserved - bytesUsed;
+}
+
+inline float PooledMemory::Stats::fragmentation() const
+{
+    return bytesFree() ? 1.f - float(largestFreeBlock) / bytesFree() : 0.f;
+}
+
+inline std::size_t PooledMemory::pageSize() const
+{
+    return m_pageSize;
+}
+
+} // ns mem
+} // ns geom
+} // ns gfx
+} // ns mcr
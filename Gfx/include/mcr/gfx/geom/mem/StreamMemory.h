@@ -0,0 +1,90 @@
+#pragma once
+
+#include <vector>
+#include <mcr/GfxExtern.h>
+#include <mcr/NonCopyable.h>
+#include <mcr/gfx/geom/mem/IVideoMemory.h>
+
+namespace mcr  {
+namespace gfx  {
+namespace geom {
+namespace mem  {
+
+//! Memory for data rewritten every frame or so. Each buffer is backed by
+//! a ring of regions: a write goes to the next region, whose previous
+//! contents are known to be consumed thanks to the per-frame fences put
+//! by endFrame(), so neither the driver nor the GPU has to sync. Regions
+//! are persistently mapped when ARB_buffer_storage is around; otherwise
+//! a buffer has a single region which is orphaned on every write.
+//!
+//! A CPU-side copy is kept, so reads and partial writes are cheap.
+class StreamMemory: public IVideoMemory, NonCopyable
+{
+public:
+    enum Target {Vertex, Index, Uniform, Indirect};
+
+    enum { NumRegions = 3 };
+
+    class Buffer: public IVideoBuffer
+    {
+    public:
+        using RefCounted::operator new;
+        using RefCounted::operator delete;
+
+        MCR_GFX_EXTERN Buffer(const StreamMemory* memory, std::size_t size, std::size_t alignment = 1);
+        MCR_GFX_EXTERN ~Buffer();
+
+        MCR_GFX_EXTERN void read(std::size_t offset, std::size_t length, void* dst) const;
+        MCR_GFX_EXTERN void write(std::size_t offset, std::size_t length, const void* src);
+
+        //! Maps the CPU-side copy; unmap() pushes it to the next region
+        MCR_GFX_EXTERN void* map(std::size_t offset, std::size_t length);
+        MCR_GFX_EXTERN bool  unmap();
+
+        std::size_t size() const { return m_shadow.size(); }
+
+        uint        vbo() const { return m_vbo; }
+        const void* offset() const { return reinterpret_cast<const void*>(m_region * m_regionSize); }
+
+    private:
+        MCR_GFX_INTERN void _push();
+
+        const StreamMemory* m_memory;
+        std::vector<byte>   m_shadow;
+
+        uint                m_vbo;
+        std::size_t         m_regionSize, m_region;
+        byte*               m_mapping;
+
+        //! Frame that last could have used a region
+        uint64              m_regionFrames[NumRegions];
+    };
+
+    MCR_GFX_EXTERN StreamMemory(Target target);
+
+    MCR_GFX_EXTERN rcptr<IVideoBuffer> allocate(std::size_t size, std::size_t alignment = 1);
+
+    //! Whether buffers are persistently mapped
+    bool                        isPersistent() const;
+
+    //! Fence off the commands issued so far; call once a frame
+    MCR_GFX_EXTERN static void  endFrame();
+
+private:
+    friend class Buffer;
+
+    uint        m_target;
+    std::size_t m_alignment;
+    bool        m_persistent;
+};
+
+
+inline bool StreamMemory::isPersistent() const
+{
+    return m_persistent;
+}
+
+} // ns mem
+} // ns geom
+} // ns gfx
+} // ns mcr
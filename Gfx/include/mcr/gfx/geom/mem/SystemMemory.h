@@ -39,6 +39,16 @@ public:
             std::memcpy(m_ptr + offset, src, length);
         }
 
+        void* map(std::size_t offset, std::size_t length)
+        {
+            return m_ptr + offset;
+        }
+
+        bool unmap()
+        {
+            return true;
+        }
+
         std::size_t size() const
         {
             return m_size;
@@ -59,7 +69,7 @@ public:
         std::size_t m_size;
     };
 
-    rcptr<IVideoBuffer> allocate(std::size_t size)
+    rcptr<IVideoBuffer> allocate(std::size_t size, std::size_t alignment = 1)
     {
         return new Buffer(size);
     }
@@ -2,14 +2,20 @@
 
 #include <mcr/GfxExtern.h>
 #include <mcr/NonCopyable.h>
+#include <mcr/Timer.h>
+#include <mcr/FlatHashMap.h>
 #include <mcr/math/Rect.h>
 #include <mcr/io/FileSystem.h>
+#include <mcr/gfx/AsyncLoader.h>
 #include <mcr/gfx/mtl/Material.h>
 
 namespace mcr {
 namespace gfx {
 namespace mtl {
 
+class MaterialCache;
+struct MaterialCacheEntry;
+
 class Manager: NonCopyable
 {
 public:
@@ -22,12 +28,12 @@ public:
     uint                        requestParamBufferBinding();
 
     bool                        addParamBuffer(mtl::ParamBuffer* buffer);
-    bool                        addParamBuffer(const std::string& name, mtl::ParamBuffer* buffer);
+    bool                        addParamBuffer(Name name, mtl::ParamBuffer* buffer);
 
     void                        removeParamBuffer(mtl::ParamBuffer* buffer);
-    void                        removeParamBuffer(const std::string& name);
+    void                        removeParamBuffer(Name name);
 
-    mtl::ParamBuffer*           paramBuffer(const std::string& name) const;
+    mtl::ParamBuffer*           paramBuffer(Name name) const;
 
     uint                        requestTexUnit();
 
@@ -36,6 +42,46 @@ public:
     MCR_GFX_EXTERN Shader*      getShader(const std::string& filename);
     MCR_GFX_EXTERN Material*    getMaterial(const std::string& filename);
 
+    //! Open \c filenames in one go ahead of the getters, which then take them
+    //! from memory. Files found missing here or by the getters aren't looked
+    //! for again until clear().
+    MCR_GFX_EXTERN void         prefetch(const std::vector<std::string>& filenames);
+
+    //! Read the material file in the background; it's parsed and set up,
+    //! shaders and all, on the context thread in AsyncLoader::pump(), which
+    //! also sets \c materialOut. Needs an async loader.
+    MCR_GFX_EXTERN AsyncLoader::Ticket loadMaterial(const std::string& filename, rcptr<Material>& materialOut);
+
+    //! With a loader set, textures are handed out right away and filled in later
+    AsyncLoader*                asyncLoader() const;
+    void                        setAsyncLoader(AsyncLoader* loader);
+
+    //! Keep parsed materials and their linked programs in \c dir (relative
+    //! to the file system root, which must exist), so later runs skip parsing,
+    //! compiling and linking. An empty \c dir turns the cache off.
+    MCR_GFX_EXTERN bool         setCacheDir(const std::string& dir);
+    MCR_GFX_EXTERN std::string  cacheDir() const;
+
+    //! Until endBatch(), shaders are compiled and materials linked without
+    //! waiting for the driver, which may then work on them all in parallel
+    //! (KHR_parallel_shader_compile). Materials are set up in endBatch() and
+    //! aren't usable before.
+    MCR_GFX_EXTERN void         beginBatch();
+    MCR_GFX_EXTERN void         endBatch();
+    bool                        isBatching() const;
+
+    //! Have \c material finish its link in endBatch()
+    void                        deferLink(Material* material);
+
+    struct CompileTiming
+    {
+        std::string filename;
+        int64       microseconds;
+    };
+
+    //! How long the driver took with each shader loaded, in load order
+    const std::vector<CompileTiming>& compileTimings() const;
+
     MCR_GFX_EXTERN void         clear();
     MCR_GFX_EXTERN void         removeUnused();
 
@@ -46,15 +92,22 @@ private:
     MCR_GFX_EXTERN void         _init();
     MCR_GFX_EXTERN void         _destroy();
 
-    MCR_GFX_INTERN void         _parseMaterial(Material* material, io::IReader* stream);
+    MCR_GFX_INTERN void         _loadMaterial(Material* material, io::IFileReader* file);
+    MCR_GFX_INTERN bool         _restoreMaterial(Material* material, const MaterialCacheEntry& entry);
+    MCR_GFX_INTERN void         _parseMaterial(Material* material, io::IReader* stream, MaterialCacheEntry* entryOut = nullptr);
+    MCR_GFX_INTERN rcptr<io::IFileReader> _openReader(const std::string& filename, bool binary);
+    MCR_GFX_INTERN uint64       _shaderHash(const std::string& filename);
+    MCR_GFX_INTERN void         _addCompileTiming(const std::string& filename, int64 submitted);
 
-    template <typename M> void  _dropAll(M& map);
-    template <typename M> void  _grabAll(M& map);
+    template <typename T> void  _removeUnused(FlatHashMap<Name, rcptr<T>>& map);
 
     io::FileSystem* m_fs;
     bool            m_ownFs;
 
+    AsyncLoader*    m_loader;
+
     IShaderPreprocessor* m_preprocessor;
+    MaterialCache*       m_cache;
 
     struct TextureData
     {
@@ -63,7 +116,7 @@ private:
             Texture* tex;
         };
 
-        std::map<std::string, rcptr<Texture>> textures;
+        FlatHashMap<Name, rcptr<Texture>> textures;
         std::vector<Unit> units;
         std::size_t nextFreeUnit;
 
@@ -74,7 +127,7 @@ private:
 
     struct ParamBufferData
     {
-        std::map<std::string, rcptr<mtl::ParamBuffer>> buffers;
+        FlatHashMap<Name, rcptr<mtl::ParamBuffer>> buffers;
         uint numBindings, nextFreeBinding;
 
         MCR_GFX_EXTERN ParamBufferData();
@@ -82,8 +135,26 @@ private:
     }
     m_pb;
 
-    std::map<std::string, rcptr<Shader>>   m_shaders;
-    std::map<std::string, rcptr<Material>> m_materials;
+    struct PendingShader
+    {
+        rcptr<Shader>   shader;
+        std::string     filename;
+        int64           submitted;
+    };
+
+    bool                            m_batching;
+    Timer                           m_compileTimer;
+    std::vector<PendingShader>      m_pendingShaders;
+    std::vector<rcptr<Material>>    m_pendingLinks;
+    std::vector<std::pair<rcptr<Material>, std::vector<std::string>>> m_pendingTextures;
+    std::vector<CompileTiming>      m_compileTimings;
+
+    // Keyed by file name
+    FlatHashMap<Name, rcptr<Shader>>   m_shaders;
+    FlatHashMap<Name, rcptr<Material>> m_materials;
+
+    FlatHashMap<Name, rcptr<io::IFileReader>> m_prefetched;
+    FlatHashMap<Name, bool>            m_missing;
 };
 
 } // ns mtl
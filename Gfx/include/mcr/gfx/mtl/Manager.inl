@@ -6,14 +6,21 @@ namespace mtl {
 // Construction/destruction
 
 inline Manager::Manager():
-    m_fs(new io::FileSystem), m_ownFs(true)
+    m_fs(new io::FileSystem), m_ownFs(true),
+    m_loader(),
+    m_preprocessor(),
+    m_cache(),
+    m_batching(false)
 {
     _init();
 }
 
 inline Manager::Manager(io::FileSystem* fs):
     m_fs(fs), m_ownFs(false),
-    m_preprocessor()
+    m_loader(),
+    m_preprocessor(),
+    m_cache(),
+    m_batching(false)
 {
     _init();
 }
@@ -39,10 +46,10 @@ inline uint Manager::requestParamBufferBinding()
 
 inline bool Manager::addParamBuffer(mtl::ParamBuffer* buffer)
 {
-    return addParamBuffer(buffer->name(), buffer);
+    return addParamBuffer(Name::intern(buffer->name().c_str()), buffer);
 }
 
-inline bool Manager::addParamBuffer(const std::string& name, mtl::ParamBuffer* buffer)
+inline bool Manager::addParamBuffer(Name name, mtl::ParamBuffer* buffer)
 {
     if (!m_pb.buffers.insert(std::make_pair(name, buffer)).second)
         return false;
@@ -56,12 +63,12 @@ inline void Manager::removeParamBuffer(mtl::ParamBuffer* buffer)
     removeParamBuffer(buffer->name());
 }
 
-inline void Manager::removeParamBuffer(const std::string& name)
+inline void Manager::removeParamBuffer(Name name)
 {
     m_pb.buffers.erase(name);
 }
 
-inline mtl::ParamBuffer* Manager::paramBuffer(const std::string& name) const
+inline mtl::ParamBuffer* Manager::paramBuffer(Name name) const
 {
     auto it = m_pb.buffers.find(name);
     return it != m_pb.buffers.end() ? it->second : nullptr;
@@ -92,23 +99,54 @@ inline bool Manager::hasOwnFs() const
     return m_ownFs;
 }
 
+inline AsyncLoader* Manager::asyncLoader() const
+{
+    return m_loader;
+}
 
-//////////////////////////////////////////////////////////////////////////
-// Collection helpers
+inline void Manager::setAsyncLoader(AsyncLoader* loader)
+{
+    m_loader = loader;
+}
 
-template <typename M>
-inline void Manager::_dropAll(M& map)
+inline bool Manager::isBatching() const
 {
-    for (auto it = map.begin(); it != map.end(); ++it)
-        if (it->second->drop())
-            it = map.erase(it);
+    return m_batching;
+}
+
+inline void Manager::deferLink(Material* material)
+{
+    m_pendingLinks.push_back(material);
 }
 
-template <typename M>
-inline void Manager::_grabAll(M& map)
+inline const std::vector<Manager::CompileTiming>& Manager::compileTimings() const
 {
-    for (auto it = map.begin(); it != map.end(); ++it)
-        it->second->grab();
+    return m_compileTimings;
+}
+
+
+//////////////////////////////////////////////////////////////////////////
+// Collection helpers
+
+template <typename T>
+inline void Manager::_removeUnused(FlatHashMap<Name, rcptr<T>>& map)
+{
+    for (auto it = map.begin(); it != map.end();)
+    {
+        // Let go of the map's reference, see whether anyone else holds one
+        T* res = it->second;
+
+        res->grab();
+        it->second = nullptr;
+
+        if (res->drop())
+            it = map.erase(it);
+        else
+        {
+            it->second = res;
+            ++it;
+        }
+    }
 }
 
 } // ns mtl
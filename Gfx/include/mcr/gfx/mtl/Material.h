@@ -21,6 +21,31 @@ struct ShaderList
     }
 };
 
+//! A linked program as the driver hands it out, plus what reflection found
+//! in it, so that it can be restored without compiling or querying anything
+struct ProgramImage
+{
+    struct Uniform
+    {
+        std::string name;
+        uint        type;
+        int         location;
+    };
+
+    struct Block
+    {
+        std::string name;
+        uint        index;
+    };
+
+    uint                    format;
+    std::vector<byte>       binary;
+    std::vector<Uniform>    uniforms;
+    std::vector<Block>      blocks;
+
+    ProgramImage(): format(0) {}
+};
+
 class Manager;
 
 class Material: public ParamBufferBase
@@ -45,6 +70,22 @@ public:
     int                     passHint() const;
     void                    setPassHint(int pass);
 
+    uint                    program() const;
+
+    //! Whether a link submitted during a manager batch is done, without waiting
+    MCR_GFX_EXTERN bool     isLinkReady() const;
+
+    //! Wait for a link submitted during a manager batch and set the material
+    //! up from the program; returns whether the program is usable
+    MCR_GFX_EXTERN bool     finishLink();
+
+    //! The linked program, if the driver supports program binaries
+    MCR_GFX_EXTERN bool     getProgramImage(ProgramImage& imageOut) const;
+
+    //! Use a previously saved program instead of linking the shaders, which
+    //! are dropped. Fails if the driver rejects the binary (e.g. after an update).
+    MCR_GFX_EXTERN bool     setProgramImage(const ProgramImage& image);
+
     MCR_GFX_EXTERN void     syncParams();
 
 private:
@@ -52,12 +93,16 @@ private:
     MCR_GFX_EXTERN ~Material();
 
     MCR_GFX_EXTERN bool _link();
+    MCR_GFX_INTERN void _resetProgram();
+    MCR_GFX_INTERN void _reflect(ProgramImage& image) const;
+    MCR_GFX_INTERN void _setup(const ProgramImage& image);
 
     Manager*    m_mgr;
     RenderState m_renderState;
     uint        m_renderStateHash;
     ShaderList  m_shaders;
     int         m_passHint;
+    bool        m_linkPending;
 
     struct ParamDef
     {
@@ -70,6 +70,11 @@ inline void Material::setPassHint(int pass)
     m_passHint = pass;
 }
 
+inline uint Material::program() const
+{
+    return m_program;
+}
+
 template <typename T>
 inline void Material::set(T RenderState::* param, const T& val)
 {
@@ -5,6 +5,7 @@
 #include <map>
 #include <mcr/GfxExtern.h>
 #include <mcr/gfx/mtl/ParamBufferBase.h>
+#include <mcr/gfx/geom/mem/IVideoMemory.h>
 
 namespace mcr {
 namespace gfx {
@@ -27,7 +28,11 @@ public:
     Usage               usage() const;
     void                setUsage(Usage usage);
 
+    //! Non-static buffers live in stream memory, so bind the range
+    //! [offset(), offset() + size()) of handle() rather than all of it
     uint                handle() const;
+    std::size_t         offset() const;
+    std::size_t         size() const;
 
     MCR_GFX_EXTERN void init();
     MCR_GFX_EXTERN void sync();
@@ -45,6 +50,7 @@ private:
 
     // implementation details
     uint                m_handle;
+    rcptr<geom::mem::IVideoBuffer> m_stream;
 };
 
 } // ns mtl
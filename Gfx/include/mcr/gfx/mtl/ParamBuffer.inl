@@ -33,7 +33,17 @@ inline void ParamBuffer::setUsage(Usage usage)
 
 inline uint ParamBuffer::handle() const
 {
-    return m_handle;
+    return m_stream ? m_stream->vbo() : m_handle;
+}
+
+inline std::size_t ParamBuffer::offset() const
+{
+    return m_stream ? reinterpret_cast<std::size_t>(m_stream->offset()) : 0u;
+}
+
+inline std::size_t ParamBuffer::size() const
+{
+    return data().size();
 }
 
 } // ns mtl
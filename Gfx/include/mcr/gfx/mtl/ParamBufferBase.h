@@ -2,8 +2,8 @@
 
 #include <string>
 #include <vector>
-#include <map>
 #include <mcr/RefCounted.h>
+#include <mcr/FlatHashMap.h>
 #include <mcr/NonCopyable.h>
 #include <mcr/gfx/mtl/ParamLayout.h>
 
@@ -17,11 +17,11 @@ public:
     int                         numParams() const;
     const std::string&          paramName(int index) const;
     ParamType                   paramType(int index) const;
-    int                         findParam(const std::string& pname) const;
+    int                         findParam(Name pname) const;
 
-    // These call findParam(pname) under the hood, each time
-    template <typename T> bool  getParam(const std::string& pname, T& valueOut) const;
-    template <typename T> bool  setParam(const std::string& pname, const T& value);
+    // These call findParam(pname) under the hood, each time; a hash lookup
+    template <typename T> bool  getParam(Name pname, T& valueOut) const;
+    template <typename T> bool  setParam(Name pname, const T& value);
 
     template <typename T> bool  getParam(int index, T& valueOut) const;
     template <typename T> bool  setParam(int index, const T& value);
@@ -42,7 +42,7 @@ private:
     std::vector<void*>  m_params;
     std::vector<byte>   m_data;
 
-    std::map<std::string, std::size_t> m_paramsByName;
+    FlatHashMap<Name, std::size_t> m_paramsByName;
 };
 
 } // ns mtl
@@ -62,20 +62,20 @@ inline ParamType ParamBufferBase::paramType(int index) const
     return index >= 0 && (std::size_t) index < m_params.size() ? m_layout.params[index].first : ParamType(ParamType::Float);
 }
 
-inline int ParamBufferBase::findParam(const std::string& pname) const
+inline int ParamBufferBase::findParam(Name pname) const
 {
     auto it = m_paramsByName.find(pname);
     return it != m_paramsByName.end() ? (int) it->second : -1;
 }
 
 template <typename T>
-inline bool ParamBufferBase::setParam(const std::string& pname, const T& value)
+inline bool ParamBufferBase::setParam(Name pname, const T& value)
 {
     return setParam(findParam(pname), value);
 }
 
 template <typename T>
-inline bool ParamBufferBase::getParam(const std::string& pname, T& valueOut) const
+inline bool ParamBufferBase::getParam(Name pname, T& valueOut) const
 {
     return getParam(findParam(pname), valueOut);
 }
@@ -176,7 +176,7 @@ inline void ParamBufferBase::setLayout(const ParamLayout& layout, bool aligned /
         auto& pdef = m_layout.params[i];
 
         m_params[i] = &m_data[offset];
-        m_paramsByName[pdef.second] = i;
+        m_paramsByName[Name::intern(pdef.second.c_str())] = i;
 
         offset += aligned ? pdef.first.sizeAligned() : pdef.first.size();
     }
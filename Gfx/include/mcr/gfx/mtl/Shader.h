@@ -51,11 +51,16 @@ public:
     void setSourceFromStream(io::IReader* stream, bool recompile = true);
 
 
-    //! Compile shader
+    //! Submit the shader for compilation; the result is only asked for when
+    //! needed, so that drivers compiling in the background aren't stalled
     MCR_GFX_EXTERN bool compile();
 
-    //! Whether shader was compiled successfully
-    bool isValid() const { return m_valid; }
+    //! Whether the driver is done compiling, without waiting for it. Always
+    //! true without KHR_parallel_shader_compile, as there is no telling then.
+    MCR_GFX_EXTERN bool isReady() const;
+
+    //! Whether shader was compiled successfully; waits for the compile
+    MCR_GFX_EXTERN bool isValid() const;
 
     //! Query shader compilation log
     MCR_GFX_EXTERN std::string log() const;
@@ -73,7 +78,7 @@ protected:
     std::vector<const char*> m_sourcePtrs;
     std::vector<int>         m_sourceLengths;
 
-    bool m_valid;
+    mutable bool m_pending, m_valid;
 };
 
 } // ns mtl
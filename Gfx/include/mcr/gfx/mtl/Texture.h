@@ -2,7 +2,7 @@
 
 #include <mcr/GfxExtern.h>
 #include <mcr/math/Vector.h>
-#include <mcr/io/IReader.h>
+#include <mcr/io/IFileReader.h>
 #include <mcr/io/IWriter.h>
 
 namespace mcr {
@@ -54,12 +54,18 @@ public:
     bool                    hasAlpha() const;
 
     MCR_GFX_EXTERN bool     load(io::IReader* stream);
+    MCR_GFX_EXTERN bool     load(io::IFileReader* stream); // uploads from the mapping if possible
     MCR_GFX_EXTERN bool     save(io::IWriter* stream) const;
 
+    //! Header sanity check that leaves GL alone, so any thread may call it
+    MCR_GFX_EXTERN static bool check(io::IFileReader* stream);
+
 protected:
     MCR_GFX_EXTERN Texture();
     MCR_GFX_EXTERN ~Texture();
 
+    MCR_GFX_INTERN void     _upload(uint fmt, int width, int height, uint size, const void* data);
+
     uint    m_handle;
     ivec2   m_size;
     bool    m_hasAlpha;
@@ -0,0 +1,190 @@
+#include "Universe.h"
+#include <mcr/gfx/AsyncLoader.h>
+
+#include <limits>
+#include <mcr/Log.h>
+#include <mcr/Profiler.h>
+#include <mcr/Timer.h>
+#include <mcr/io/MemoryReader.h>
+
+namespace mcr {
+namespace gfx {
+
+// Jobs are created and destroyed on the context thread; a worker only
+// fills in the stream and the verdict, then hands the job back. RefCounted
+// isn't thread-safe, so the worker must hold no other reference to the
+// stream by the time the job is published.
+struct AsyncLoader::Job
+{
+    std::string             filename;
+    bool                    binary;
+    CheckFn                 check;
+    UploadFn                upload;
+
+    rcptr<io::IFileReader>  stream;
+    bool                    valid;
+
+    std::promise<bool>      result;
+};
+
+namespace {
+
+// Fault the pages of a mapped file in, so the upload stage doesn't stall on disk
+void touch(const io::IFileReader* stream)
+{
+    auto data = static_cast<const volatile byte*>(stream->data());
+    auto size = (std::size_t) stream->size();
+
+    byte sum = 0;
+
+    for (std::size_t i = 0; i < size; i += 4096)
+        sum ^= data[i];
+
+    (void) sum;
+}
+
+} // ns
+
+AsyncLoader::AsyncLoader(io::FileSystem* fs, uint numThreads):
+    m_fs(fs),
+    m_numPending(0u),
+    m_pool(numThreads) {}
+
+AsyncLoader::~AsyncLoader()
+{
+    m_pool.wait();
+
+    while (auto job = _popReady())
+    {
+        job->result.set_value(false);
+        delete job;
+    }
+}
+
+AsyncLoader::Ticket AsyncLoader::load(const char* filename, bool binary, CheckFn check, const UploadFn& upload)
+{
+    auto job = new Job;
+
+    job->filename = filename;
+    job->binary   = binary;
+    job->check    = check;
+    job->upload   = upload;
+    job->valid    = false;
+
+    Ticket ticket = job->result.get_future().share();
+
+    ++m_numPending;
+    m_pool.enqueue(std::bind(&AsyncLoader::_read, this, job));
+
+    return ticket;
+}
+
+AsyncLoader::Ticket AsyncLoader::loadMesh(
+    const char* filename,
+    geom::mem::IVideoMemory* vertMem,
+    geom::mem::IVideoMemory* idxMem,
+    geom::Mesh& meshOut)
+{
+    auto meshPtr = &meshOut;
+
+    return load(filename, true, &geom::Mesh::check,
+        [=] (io::IFileReader* stream)
+        {
+            return geom::Mesh::load(stream, vertMem, idxMem, *meshPtr);
+        });
+}
+
+AsyncLoader::Ticket AsyncLoader::loadTexture(const char* filename, mtl::Texture* texture)
+{
+    rcptr<mtl::Texture> texPtr = texture;
+
+    return load(filename, true, &mtl::Texture::check,
+        [=] (io::IFileReader* stream)
+        {
+            return texPtr->load(stream);
+        });
+}
+
+uint AsyncLoader::pump(int64 budgetMicroseconds)
+{
+    Timer timer;
+    uint numDone = 0;
+
+    while (auto job = _popReady())
+    {
+        MCR_PROFILE_SCOPE("AsyncLoader::upload");
+
+        auto success = job->valid && job->upload(job->stream);
+
+        if (!success)
+            g_log->warn("Failed to load %s", job->filename.c_str());
+
+        job->result.set_value(success);
+        delete job;
+
+        --m_numPending;
+        ++numDone;
+
+        timer.refresh();
+        if (timer.microseconds() >= budgetMicroseconds)
+            break;
+    }
+
+    return numDone;
+}
+
+void AsyncLoader::finish()
+{
+    while (m_numPending)
+    {
+        {
+            std::unique_lock<std::mutex> lock(m_readyMutex);
+
+            while (m_ready.empty())
+                m_readyAdded.wait(lock);
+        }
+
+        pump(std::numeric_limits<int64>::max());
+    }
+}
+
+//////////////////////////////////////////////////////////////////////////
+// Internals
+
+void AsyncLoader::_read(Job* job)
+{
+    MCR_PROFILE_SCOPE("AsyncLoader::read");
+
+    job->stream = m_fs->openReader(job->filename.c_str(), job->binary);
+
+    if (job->stream)
+    {
+        job->stream = io::MemoryReader::fromFile(job->stream);
+        touch(job->stream);
+
+        job->valid = !job->check || job->check(job->stream);
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(m_readyMutex);
+        m_ready.push_back(job);
+    }
+
+    m_readyAdded.notify_one();
+}
+
+AsyncLoader::Job* AsyncLoader::_popReady()
+{
+    std::lock_guard<std::mutex> lock(m_readyMutex);
+
+    if (m_ready.empty())
+        return nullptr;
+
+    auto job = m_ready.front();
+    m_ready.pop_front();
+
+    return job;
+}
+
+} // ns gfx
+} // ns mcr
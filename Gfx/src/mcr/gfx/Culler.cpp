@@ -0,0 +1,122 @@
+#include "Universe.h"
+#include <mcr/gfx/Culler.h>
+
+#include <mcr/math/Simd.h>
+
+namespace mcr {
+namespace gfx {
+
+namespace {
+
+// Big enough to straddle every plane, small enough to stay finite once multiplied
+const float UnknownExtent = 1e30f;
+
+} // ns
+
+
+Culler::Culler():
+    m_size(0) {}
+
+Culler::~Culler() {}
+
+uint Culler::add(const bbox& box)
+{
+    if (m_size % 4 == 0)
+    {
+        for (int i = 0; i < 3; ++i)
+        {
+            m_centers[i].resize(m_size + 4);
+            m_extents[i].resize(m_size + 4);
+        }
+    }
+
+    auto center = box.isEmpty() ? vec3()              : box.center();
+    auto extent = box.isEmpty() ? vec3(UnknownExtent) : box.extent();
+
+    for (int i = 0; i < 3; ++i)
+    {
+        m_centers[i][m_size] = center[i];
+        m_extents[i][m_size] = extent[i];
+    }
+
+    return uint(m_size++);
+}
+
+void Culler::cull(const frustum& view, std::vector<uint>& visibleOut) const
+{
+#ifdef MCR_MATH_SSE
+    __m128 planes[frustum::NumPlanes][4], absNormals[frustum::NumPlanes][3];
+
+    for (int p = 0; p < frustum::NumPlanes; ++p)
+    {
+        auto& plane = view.plane(p);
+
+        for (int i = 0; i < 4; ++i)
+            planes[p][i] = _mm_set1_ps(plane[i]);
+
+        for (int i = 0; i < 3; ++i)
+            absNormals[p][i] = _mm_set1_ps(std::abs(plane[i]));
+    }
+
+    const __m128 zero = _mm_setzero_ps();
+
+    for (std::size_t base = 0; base < m_size; base += 4)
+    {
+        __m128
+            cx = _mm_loadu_ps(&m_centers[0][base]),
+            cy = _mm_loadu_ps(&m_centers[1][base]),
+            cz = _mm_loadu_ps(&m_centers[2][base]),
+            ex = _mm_loadu_ps(&m_extents[0][base]),
+            ey = _mm_loadu_ps(&m_extents[1][base]),
+            ez = _mm_loadu_ps(&m_extents[2][base]);
+
+        __m128 inside = _mm_cmpeq_ps(zero, zero);
+
+        for (int p = 0; p < frustum::NumPlanes; ++p)
+        {
+            // distance + projected extent, which is negative only for boxes fully outside
+            __m128 d = _mm_add_ps(
+                _mm_add_ps(_mm_mul_ps(cx, planes[p][0]), _mm_mul_ps(cy, planes[p][1])),
+                _mm_add_ps(_mm_mul_ps(cz, planes[p][2]), planes[p][3]));
+
+            __m128 r = _mm_add_ps(
+                _mm_add_ps(_mm_mul_ps(ex, absNormals[p][0]), _mm_mul_ps(ey, absNormals[p][1])),
+                _mm_mul_ps(ez, absNormals[p][2]));
+
+            inside = _mm_and_ps(inside, _mm_cmpge_ps(_mm_add_ps(d, r), zero));
+        }
+
+        int mask = _mm_movemask_ps(inside);
+
+        if (base + 4 > m_size) // padding
+            mask &= (1 << (m_size - base)) - 1;
+
+        for (uint i = 0; mask; ++i, mask >>= 1)
+            if (mask & 1)
+                visibleOut.push_back(uint(base) + i);
+    }
+#else
+    for (std::size_t i = 0; i < m_size; ++i)
+    {
+        bool inside = true;
+
+        for (int p = 0; p < frustum::NumPlanes && inside; ++p)
+        {
+            auto& plane = view.plane(p);
+
+            float d = m_centers[0][i] * plane.x() + m_centers[1][i] * plane.y() + m_centers[2][i] * plane.z() + plane.w();
+            float r = m_extents[0][i] * std::abs(plane.x())
+                    + m_extents[1][i] * std::abs(plane.y())
+                    + m_extents[2][i] * std::abs(plane.z());
+
+            inside = d + r >= 0.f;
+        }
+
+        if (inside)
+            visibleOut.push_back(uint(i));
+    }
+#endif
+}
+
+} // ns gfx
+} // ns mcr
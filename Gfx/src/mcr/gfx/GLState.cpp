@@ -1,7 +1,15 @@
 #include "Universe.h"
 #include "GLState.h"
 
+#include <algorithm>
 #include <mcr/Log.h>
+#include "GLEnums.inl"
+
+#if defined(MCR_GFX_HAS_EGL)
+#   define EGL_NO_X11
+#   define MESA_EGL_NO_X11_HEADERS
+#   include <EGL/egl.h>
+#endif
 
 namespace mcr {
 namespace gfx {
@@ -51,11 +59,22 @@ static void GLAPIENTRY onGLDebug(
 
 GLState::GLState():
     m_activeTexUnit(0),
-    m_activeVertexArray(0)
+    m_activeVertexArray(0),
+    m_stats()
 {
     glewExperimental = true;
 
-    auto err = glewInit();
+    GLenum err;
+
+#if defined(MCR_GFX_HAS_EGL) && defined(GLEW_ERROR_NO_GLX_DISPLAY)
+    // glewInit() also loads the window system's entry points; a GLX build
+    // fails on an EGL context for want of a display, and GL's are enough
+    if (eglGetCurrentContext() != EGL_NO_CONTEXT)
+        err = glewContextInit();
+    else
+#endif
+        err = glewInit();
+
     if (err != GLEW_OK)
         g_log->error("glewInit() failed: %s", glewGetErrorString(err));
 
@@ -128,16 +147,23 @@ uint GLState::boundTexture() const
 void GLState::bindTexture(uint tex)
 {
     if (m_texUnits[m_activeTexUnit] == tex)
+    {
+        ++m_stats.skipped.textures;
         return;
+    }
 
     glBindTexture(GL_TEXTURE_2D, tex);
     m_texUnits[m_activeTexUnit] = tex;
+    ++m_stats.issued.textures;
 }
 
 void GLState::bindTexture(uint unit, uint tex)
 {
     if (m_texUnits[unit] == tex)
+    {
+        ++m_stats.skipped.textures;
         return;
+    }
 
     setActiveTexUnit(unit);
     bindTexture(tex);
@@ -151,53 +177,119 @@ uint GLState::activeProgram() const
 void GLState::setActiveProgram(uint program)
 {
     if (m_activeProgram == program)
+    {
+        ++m_stats.skipped.programs;
         return;
+    }
 
     glUseProgram(program);
     m_activeProgram = program;
+    ++m_stats.issued.programs;
 }
 
 uint GLState::boundBuffer(uint target) const
 {
     uint tindex = bufferTargetEnumToIndex(target);
 
-    if (m_activeVertexArray && tindex >= ArrayBuffer && tindex <= ElementArrayBuffer)
-        return m_vertexArrays[m_activeVertexArray].buffers[tindex - ArrayBuffer];
+    // Only the element array binding is part of VAO state
+    if (m_activeVertexArray && tindex == ElementArrayBuffer)
+        return m_vertexArrays[m_activeVertexArray].indexBuffer;
 
     return m_buffers[tindex];
 }
 
 uint GLState::boundBuffer(uint target, uint index) const
 {
-    return m_buffersIndexed[bufferTargetEnumToIndex(target)][index];
+    return m_buffersIndexed[bufferTargetEnumToIndex(target)][index].buffer;
 }
 
 void GLState::bindBuffer(uint target, uint buffer)
 {
     uint tindex = bufferTargetEnumToIndex(target);
 
-    uint& binding = m_activeVertexArray
-                  ? m_vertexArrays[m_activeVertexArray].buffers[tindex - ArrayBuffer]
+    uint& binding = m_activeVertexArray && tindex == ElementArrayBuffer
+                  ? m_vertexArrays[m_activeVertexArray].indexBuffer
                   : m_buffers[tindex];
     
     if (binding == buffer)
+    {
+        ++m_stats.skipped.buffers;
         return;
+    }
 
     glBindBuffer(target, buffer);
     binding = buffer;
+    ++m_stats.issued.buffers;
 }
 
 void GLState::bindBufferBase(uint target, uint index, uint buffer)
 {
     uint tindex = bufferTargetEnumToIndex(target);
-    uint& binding = m_buffersIndexed[tindex][index];
+    auto& binding = m_buffersIndexed[tindex][index];
 
-    if (binding == buffer)
+    if (binding.buffer == buffer && !binding.size)
+    {
+        ++m_stats.skipped.buffers;
         return;
+    }
 
     glBindBufferBase(target, index, buffer);
-    binding = buffer;
+    binding.buffer = buffer;
+    binding.offset = binding.size = 0;
     m_buffers[tindex] = buffer;
+    ++m_stats.issued.buffers;
+}
+
+void GLState::bindBufferRange(uint target, uint index, uint buffer, std::size_t offset, std::size_t size)
+{
+    uint tindex = bufferTargetEnumToIndex(target);
+    auto& binding = m_buffersIndexed[tindex][index];
+
+    if (binding.buffer == buffer && binding.offset == offset && binding.size == size)
+    {
+        ++m_stats.skipped.buffers;
+        return;
+    }
+
+    glBindBufferRange(target, index, buffer, (GLintptr) offset, (GLsizeiptr) size);
+    binding.buffer = buffer;
+    binding.offset = offset;
+    binding.size   = size;
+    m_buffers[tindex] = buffer;
+    ++m_stats.issued.buffers;
+}
+
+void GLState::deleteBuffer(uint buffer)
+{
+    if (!buffer)
+        return;
+
+    for (auto it = m_vaoCache.begin(); it != m_vaoCache.end();)
+    {
+        if (it->first.vbo == buffer || it->first.ibo == buffer || it->first.instanceVbo == buffer)
+        {
+            deleteVertexArray(it->second.handle);
+            it = m_vaoCache.erase(it);
+        }
+        else
+            ++it;
+    }
+
+    glDeleteBuffers(1, &buffer);
+
+    // GL unbinds it from everywhere in the context, and so do we
+    for (uint i = 0; i < NumBufferTargets; ++i)
+        if (m_buffers[i] == buffer)
+            m_buffers[i] = 0;
+
+    for (uint i = 0; i < NumIndexedBufferTargets; ++i)
+        for (auto it = m_buffersIndexed[i].begin(); it != m_buffersIndexed[i].end(); ++it)
+            if (it->buffer == buffer)
+                *it = IndexedBinding();
+
+    for (auto it = m_vertexArrays.begin(); it != m_vertexArrays.end(); ++it)
+        if (it->indexBuffer == buffer)
+            it->indexBuffer = 0;
 }
 
 uint GLState::boundVertexArray() const
@@ -208,15 +300,124 @@ uint GLState::boundVertexArray() const
 void GLState::bindVertexArray(uint va)
 {
     if (m_activeVertexArray == va)
+    {
+        ++m_stats.skipped.vertexArrays;
         return;
+    }
 
     glBindVertexArray(va);
     m_activeVertexArray = va;
+    ++m_stats.issued.vertexArrays;
 
     if (m_vertexArrays.size() <= va)
         m_vertexArrays.resize(va + 1);
 }
 
+uint GLState::vertexArray(const geom::VertexFormat& format, uint vbo, uint ibo, std::size_t vertexOffset,
+                          const geom::VertexFormat* instanceFormat, uint instanceVbo, std::size_t instanceOffset)
+{
+    if (!instanceFormat)
+        instanceVbo = 0, instanceOffset = 0;
+
+    VAOKey key =
+    {
+        vbo, ibo, instanceVbo,
+        vertexOffset, instanceOffset,
+        format.hash(), instanceFormat ? instanceFormat->hash() : 0
+    };
+
+    auto& cached = m_vaoCache[key];
+
+    if (cached.handle)
+    {
+        if (cached.format == format && (!instanceFormat || cached.instanceFormat == *instanceFormat))
+            return cached.handle;
+
+        deleteVertexArray(cached.handle);
+    }
+
+    glGenVertexArrays(1, &cached.handle);
+    cached.format = format;
+
+    bindVertexArray(cached.handle);
+    bindBuffer(GL_ARRAY_BUFFER, vbo);
+    bindBuffer(GL_ELEMENT_ARRAY_BUFFER, ibo);
+
+    auto location = setupAttribs(format, 0, vertexOffset, 0);
+
+    if (instanceFormat)
+    {
+        cached.instanceFormat = *instanceFormat;
+
+        bindBuffer(GL_ARRAY_BUFFER, instanceVbo);
+        setupAttribs(*instanceFormat, location, instanceOffset, 1);
+    }
+
+    return cached.handle;
+}
+
+uint GLState::setupAttribs(const geom::VertexFormat& format, uint location, std::size_t offset, uint divisor)
+{
+    for (uint i = 0; i < format.numAttribs(); ++i)
+    {
+        auto& attrib = format.attrib(i);
+
+        if (!attrib.length)
+        {
+            ++location;
+            continue;
+        }
+
+        // matrices and such are fed 4 components per location
+        for (uint component = 0; component < attrib.length; component += 4, ++location)
+        {
+            glEnableVertexAttribArray(location);
+            glVertexAttribPointer(location,
+                std::min(attrib.length - component, 4u), g_attribTypeTable[attrib.type], GL_FALSE, format.stride(),
+                reinterpret_cast<const GLvoid*>(offset + attrib.offset + component * attrib.type.size()));
+
+            if (divisor)
+                glVertexAttribDivisor(location, divisor);
+        }
+    }
+
+    return location;
+}
+
+void GLState::deleteVertexArray(uint va)
+{
+    if (m_activeVertexArray == va)
+        m_activeVertexArray = 0;
+
+    glDeleteVertexArrays(1, &va);
+
+    if (va < m_vertexArrays.size())
+        m_vertexArrays[va] = VAO();
+}
+
+bool GLState::VAOKey::operator<(const VAOKey& rhs) const
+{
+    if (vbo != rhs.vbo)
+        return vbo < rhs.vbo;
+
+    if (ibo != rhs.ibo)
+        return ibo < rhs.ibo;
+
+    if (instanceVbo != rhs.instanceVbo)
+        return instanceVbo < rhs.instanceVbo;
+
+    if (vertexOffset != rhs.vertexOffset)
+        return vertexOffset < rhs.vertexOffset;
+
+    if (instanceOffset != rhs.instanceOffset)
+        return instanceOffset < rhs.instanceOffset;
+
+    if (formatHash != rhs.formatHash)
+        return formatHash < rhs.formatHash;
+
+    return instanceFormatHash < rhs.instanceFormatHash;
+}
+
 uint GLState::bufferTargetEnumToIndex(uint target)
 {
     switch (target)
@@ -230,7 +431,7 @@ uint GLState::bufferTargetEnumToIndex(uint target)
     case GL_TEXTURE_BUFFER:             return TextureBuffer;
     //case GL_COPY_READ_BUFFER:           return CopyReadBuffer;
     //case GL_COPY_WRITE_BUFFER:          return CopyWriteBuffer;
-    //case GL_DRAW_INDIRECT_BUFFER:       return DrawIndirectBuffer;
+    case GL_DRAW_INDIRECT_BUFFER:       return DrawIndirectBuffer;
     //case GL_DISPATCH_INDIRECT_BUFFER:   return DispatchIndirectBuffer;
     //case GL_PIXEL_PACK_BUFFER:          return PixelPackBuffer;
     //case GL_PIXEL_UNPACK_BUFFER:        return PixelUnpackBuffer;
@@ -248,5 +449,10 @@ const std::string& GLState::vendor() const
     return m_vendorString;
 }
 
+RenderStats& GLState::stats()
+{
+    return m_stats;
+}
+
 } // ns gfx
 } // ns mcr
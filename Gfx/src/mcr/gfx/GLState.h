@@ -1,8 +1,12 @@
 // Internal header
 #pragma once
 
+#include <map>
+#include <string>
 #include <vector>
 #include <mcr/math/Rect.h>
+#include <mcr/gfx/RenderStats.h>
+#include <mcr/gfx/geom/VertexFormat.h>
 
 namespace mcr {
 namespace gfx {
@@ -29,13 +33,25 @@ public:
     uint               boundBuffer(uint target, uint index) const;
     void               bindBuffer(uint target, uint buffer);
     void               bindBufferBase(uint target, uint index, uint buffer);
+    void               bindBufferRange(uint target, uint index, uint buffer, std::size_t offset, std::size_t size);
+
+    void               deleteBuffer(uint buffer); // also drops the VAOs referring to it
 
     uint               boundVertexArray() const;
     void               bindVertexArray(uint va);
 
+    // A VAO set up for the given layout, built on first request. Instance
+    // attributes follow the vertex ones; those longer than 4 take several locations.
+    uint               vertexArray(const geom::VertexFormat& format, uint vbo, uint ibo, std::size_t vertexOffset,
+                                   const geom::VertexFormat* instanceFormat = nullptr,
+                                   uint instanceVbo = 0, std::size_t instanceOffset = 0);
+
     const std::string& renderer() const;
     const std::string& vendor() const;
 
+    // Counters of the frame in progress, reset by Renderer::endFrame()
+    RenderStats&       stats();
+
 private:
     enum IndexedBufferTarget
     {
@@ -52,7 +68,7 @@ private:
         TextureBuffer,
         //CopyReadBuffer,
         //CopyWriteBuffer,
-        //DrawIndirectBuffer,
+        DrawIndirectBuffer,
         //DispatchIndirectBuffer,
         //PixelPackBuffer,
         //PixelUnpackBuffer,
@@ -70,8 +86,36 @@ private:
         VAO(): vertexBuffer(0), indexBuffer(0) {}
     };
 
+    struct IndexedBinding
+    {
+        uint buffer;
+        std::size_t offset, size; // size is 0 for whole buffer bindings
+
+        IndexedBinding(): buffer(0), offset(0), size(0) {}
+    };
+
+    struct VAOKey
+    {
+        uint vbo, ibo, instanceVbo;
+        std::size_t vertexOffset, instanceOffset;
+        uint64 formatHash, instanceFormatHash;
+
+        bool operator<(const VAOKey& rhs) const;
+    };
+
+    struct CachedVAO
+    {
+        uint handle;
+        geom::VertexFormat format, instanceFormat; // to tell hash collisions apart
+
+        CachedVAO(): handle(0) {}
+    };
+
     static uint bufferTargetEnumToIndex(uint target);
 
+    void                deleteVertexArray(uint va);
+    static uint         setupAttribs(const geom::VertexFormat& format, uint location, std::size_t offset, uint divisor);
+
     irect               m_viewport;
 
     std::vector<uint>   m_texUnits;
@@ -79,14 +123,18 @@ private:
 
     uint                m_activeProgram;
 
-    std::vector<uint>   m_buffersIndexed[NumIndexedBufferTargets];
+    std::vector<IndexedBinding> m_buffersIndexed[NumIndexedBufferTargets];
     uint                m_buffers       [NumBufferTargets];
 
     std::vector<VAO>    m_vertexArrays;
     uint                m_activeVertexArray;
 
+    std::map<VAOKey, CachedVAO> m_vaoCache;
+
     std::string         m_vendorString;
     std::string         m_rendererString;
+
+    RenderStats         m_stats;
 };
 
 
@@ -0,0 +1,98 @@
+#include "Universe.h"
+#include <mcr/gfx/GpuProfiler.h>
+
+namespace mcr {
+namespace gfx {
+
+GpuProfiler& GpuProfiler::instance()
+{
+    static GpuProfiler s_instance;
+    return s_instance;
+}
+
+// The queries are left to the context to clean up, it may well be gone by
+// the time static objects are destroyed
+GpuProfiler::GpuProfiler():
+    m_frame(0),
+    m_track(Profiler::track("GPU")) {}
+
+int GpuProfiler::begin(const char* name)
+{
+    if (!Profiler::isEnabled() || !(GLEW_VERSION_3_3 || GLEW_ARB_timer_query))
+        return -1;
+
+    Zone zone;
+    zone.name       = name;
+    zone.queries[0] = _query();
+    zone.queries[1] = _query();
+
+    glQueryCounter(zone.queries[0], GL_TIMESTAMP);
+
+    auto& frame = m_frames[m_frame];
+    frame.push_back(zone);
+
+    return int(frame.size() - 1);
+}
+
+void GpuProfiler::end(int zone)
+{
+    if (zone >= 0)
+        glQueryCounter(m_frames[m_frame][(std::size_t) zone].queries[1], GL_TIMESTAMP);
+}
+
+void GpuProfiler::endFrame()
+{
+    m_frame = (m_frame + 1) % (Latency + 1);
+    _collect(m_frames[m_frame]);
+}
+
+void GpuProfiler::_collect(std::vector<Zone>& zones)
+{
+    if (zones.empty())
+        return;
+
+    // Map GPU time onto the Profiler's clock; the query doesn't wait for the GPU
+    GLint64 gpuNow = 0;
+    glGetInteger64v(GL_TIMESTAMP, &gpuNow);
+
+    auto offset = Profiler::now() - gpuNow;
+
+    for (auto it = zones.begin(); it != zones.end(); ++it)
+    {
+        GLint available = 0;
+        glGetQueryObjectiv(it->queries[1], GL_QUERY_RESULT_AVAILABLE, &available);
+
+        if (available)
+        {
+            GLuint64 begin = 0, end = 0;
+            glGetQueryObjectui64v(it->queries[0], GL_QUERY_RESULT, &begin);
+            glGetQueryObjectui64v(it->queries[1], GL_QUERY_RESULT, &end);
+
+            Profiler::record(m_track, it->name, (int64) begin + offset, (int64) (end - begin));
+        }
+
+        m_freeQueries.push_back(it->queries[0]);
+        m_freeQueries.push_back(it->queries[1]);
+    }
+
+    zones.clear();
+}
+
+uint GpuProfiler::_query()
+{
+    if (m_freeQueries.empty())
+    {
+        GLuint queries[16];
+        glGenQueries(16, queries);
+
+        m_freeQueries.insert(m_freeQueries.end(), queries, queries + 16);
+    }
+
+    auto query = m_freeQueries.back();
+    m_freeQueries.pop_back();
+
+    return query;
+}
+
+} // ns gfx
+} // ns mcr
@@ -0,0 +1,289 @@
+#include "Universe.h"
+#include <mcr/gfx/HeadlessContext.h>
+
+#include <cstdio>
+#include <cstring>
+#include <mcr/Log.h>
+#include "mcr/gfx/GLState.h"
+
+#if defined(MCR_GFX_HAS_EGL)
+#   define EGL_NO_X11
+#   define MESA_EGL_NO_X11_HEADERS
+#   include <EGL/egl.h>
+#   include <EGL/eglext.h>
+#endif
+
+#ifndef EGL_PLATFORM_SURFACELESS_MESA
+#   define EGL_PLATFORM_SURFACELESS_MESA 0x31DD
+#endif
+
+namespace mcr {
+namespace gfx {
+
+#if defined(MCR_GFX_HAS_EGL)
+
+namespace {
+
+bool hasExtension(const char* extensions, const char* name)
+{
+    if (!extensions)
+        return false;
+
+    auto length = std::strlen(name);
+
+    for (auto ext = std::strstr(extensions, name); ext; ext = std::strstr(ext + length, name))
+        if ((ext == extensions || ext[-1] == ' ') && (ext[length] == ' ' || !ext[length]))
+            return true;
+
+    return false;
+}
+
+// Mesa's surfaceless platform needs neither X nor a DRM master, which is what
+// render farm and CI boxes have; other implementations get the default display
+EGLDisplay getDisplay()
+{
+    auto clientExtensions = eglQueryString(EGL_NO_DISPLAY, EGL_EXTENSIONS);
+
+    if (hasExtension(clientExtensions, "EGL_MESA_platform_surfaceless"))
+    {
+        auto getPlatformDisplay = (PFNEGLGETPLATFORMDISPLAYEXTPROC) eglGetProcAddress("eglGetPlatformDisplayEXT");
+
+        if (getPlatformDisplay)
+        {
+            auto display = getPlatformDisplay(EGL_PLATFORM_SURFACELESS_MESA, EGL_DEFAULT_DISPLAY, nullptr);
+
+            if (display != EGL_NO_DISPLAY)
+                return display;
+        }
+    }
+
+    return eglGetDisplay(EGL_DEFAULT_DISPLAY);
+}
+
+} // ns
+
+#endif
+
+
+HeadlessContext::HeadlessContext():
+    m_display(nullptr),
+    m_context(nullptr),
+    m_surface(nullptr),
+    m_framebuffer(0),
+    m_colorBuffer(0),
+    m_depthBuffer(0) {}
+
+HeadlessContext::~HeadlessContext()
+{
+    destroy();
+}
+
+bool HeadlessContext::create(const ivec2& size)
+{
+    destroy();
+
+#if defined(MCR_GFX_HAS_EGL)
+
+    auto display = getDisplay();
+
+    EGLint major, minor;
+    if (display == EGL_NO_DISPLAY || !eglInitialize(display, &major, &minor))
+    {
+        g_log->error("No EGL display for a headless context");
+        return false;
+    }
+
+    m_display = display;
+
+    // Rendering goes to our own framebuffer, so the surface is only there if it has to be
+    bool surfaceless = hasExtension(eglQueryString(display, EGL_EXTENSIONS), "EGL_KHR_surfaceless_context");
+
+    const EGLint configAttribs[] =
+    {
+        EGL_SURFACE_TYPE,    surfaceless ? 0 : EGL_PBUFFER_BIT,
+        EGL_RENDERABLE_TYPE, EGL_OPENGL_BIT,
+        EGL_NONE
+    };
+
+    EGLConfig config;
+    EGLint numConfigs = 0;
+
+    if (!eglBindAPI(EGL_OPENGL_API)
+    ||  !eglChooseConfig(display, configAttribs, &config, 1, &numConfigs) || !numConfigs)
+    {
+        g_log->error("EGL %d.%d has no desktop OpenGL config", major, minor);
+        destroy();
+        return false;
+    }
+
+    if (!surfaceless)
+    {
+        const EGLint pbufferAttribs[] = { EGL_WIDTH, 1, EGL_HEIGHT, 1, EGL_NONE };
+
+        if ((m_surface = eglCreatePbufferSurface(display, config, pbufferAttribs)) == EGL_NO_SURFACE)
+        {
+            g_log->error("eglCreatePbufferSurface() failed: %#x", eglGetError());
+            destroy();
+            return false;
+        }
+    }
+
+    // 3.2 core, like windows get on the Mac; without context attributes the
+    // version check below is all there is
+    bool createContext = major > 1 || minor >= 5
+                      || hasExtension(eglQueryString(display, EGL_EXTENSIONS), "EGL_KHR_create_context");
+
+    const EGLint contextAttribs[] =
+    {
+        EGL_CONTEXT_MAJOR_VERSION_KHR,       3,
+        EGL_CONTEXT_MINOR_VERSION_KHR,       2,
+        EGL_CONTEXT_OPENGL_PROFILE_MASK_KHR, EGL_CONTEXT_OPENGL_CORE_PROFILE_BIT_KHR,
+        EGL_NONE
+    };
+
+    if ((m_context = eglCreateContext(display, config, EGL_NO_CONTEXT, createContext ? contextAttribs : nullptr)) == EGL_NO_CONTEXT)
+    {
+        g_log->error("eglCreateContext() failed: %#x", eglGetError());
+        m_context = nullptr;
+        destroy();
+        return false;
+    }
+
+    if (!makeCurrent())
+    {
+        g_log->error("eglMakeCurrent() failed: %#x", eglGetError());
+        destroy();
+        return false;
+    }
+
+    int glMajor = 0, glMinor = 0;
+    std::sscanf(reinterpret_cast<const char*>(glGetString(GL_VERSION)), "%d.%d", &glMajor, &glMinor);
+
+    if (glMajor < 3 || (glMajor == 3 && glMinor < 2))
+    {
+        g_log->error("Headless context has GL %d.%d, 3.2 is needed", glMajor, glMinor);
+        destroy();
+        return false;
+    }
+
+    m_size = size;
+
+    // There's no window to size the viewport after, and GLState takes it over on creation
+    glViewport(0, 0, size.x(), size.y());
+    *g_glState;
+
+    g_log->info("Headless context: EGL %d.%d, %s, GL %s", major, minor,
+                surfaceless ? "surfaceless" : "pbuffer", glGetString(GL_VERSION));
+
+    _createFramebuffer();
+    return true;
+
+#else
+
+    (void) size;
+
+    g_log->error("Headless contexts need EGL, which massacre-gfx was built without");
+    return false;
+
+#endif
+}
+
+void HeadlessContext::destroy()
+{
+#if defined(MCR_GFX_HAS_EGL)
+
+    if (!m_display)
+        return;
+
+    if (m_context && makeCurrent())
+        _destroyFramebuffer();
+
+    eglMakeCurrent(m_display, EGL_NO_SURFACE, EGL_NO_SURFACE, EGL_NO_CONTEXT);
+
+    if (m_context)
+        eglDestroyContext(m_display, m_context);
+
+    if (m_surface)
+        eglDestroySurface(m_display, m_surface);
+
+    eglTerminate(m_display);
+
+#endif
+
+    m_display = m_context = m_surface = nullptr;
+}
+
+bool HeadlessContext::makeCurrent()
+{
+#if defined(MCR_GFX_HAS_EGL)
+
+    auto surface = m_surface ? m_surface : EGL_NO_SURFACE;
+    return m_context && eglMakeCurrent(m_display, surface, surface, m_context);
+
+#else
+
+    return false;
+
+#endif
+}
+
+void HeadlessContext::resize(const ivec2& size)
+{
+    if (!isValid() || size == m_size)
+        return;
+
+    _destroyFramebuffer();
+    m_size = size;
+    _createFramebuffer();
+
+    g_glState->setViewport(size);
+}
+
+void HeadlessContext::finish()
+{
+    if (isValid())
+        glFinish();
+}
+
+
+//////////////////////////////////////////////////////////////////////////
+// Render target
+
+void HeadlessContext::_createFramebuffer()
+{
+    glGenRenderbuffers(1, &m_colorBuffer);
+    glBindRenderbuffer(GL_RENDERBUFFER, m_colorBuffer);
+    glRenderbufferStorage(GL_RENDERBUFFER, GL_RGBA8, m_size.x(), m_size.y());
+
+    glGenRenderbuffers(1, &m_depthBuffer);
+    glBindRenderbuffer(GL_RENDERBUFFER, m_depthBuffer);
+    glRenderbufferStorage(GL_RENDERBUFFER, GL_DEPTH24_STENCIL8, m_size.x(), m_size.y());
+
+    glBindRenderbuffer(GL_RENDERBUFFER, 0);
+
+    // Stays bound, so that drawing, clears and reads all go here
+    glGenFramebuffers(1, &m_framebuffer);
+    glBindFramebuffer(GL_FRAMEBUFFER, m_framebuffer);
+    glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0,        GL_RENDERBUFFER, m_colorBuffer);
+    glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_DEPTH_STENCIL_ATTACHMENT, GL_RENDERBUFFER, m_depthBuffer);
+
+    auto status = glCheckFramebufferStatus(GL_FRAMEBUFFER);
+    if (status != GL_FRAMEBUFFER_COMPLETE)
+        g_log->error("Headless render target (%dx%d) incomplete: %#x", m_size.x(), m_size.y(), status);
+}
+
+void HeadlessContext::_destroyFramebuffer()
+{
+    if (!m_framebuffer)
+        return;
+
+    glBindFramebuffer(GL_FRAMEBUFFER, 0);
+    glDeleteFramebuffers(1, &m_framebuffer);
+    glDeleteRenderbuffers(1, &m_colorBuffer);
+    glDeleteRenderbuffers(1, &m_depthBuffer);
+
+    m_framebuffer = m_colorBuffer = m_depthBuffer = 0;
+}
+
+} // ns gfx
+} // ns mcr
@@ -0,0 +1,73 @@
+#include "Universe.h"
+#include <mcr/gfx/InstanceBatcher.h>
+
+namespace mcr {
+namespace gfx {
+
+InstanceBatcher::InstanceBatcher(geom::mem::IVideoMemory* memory):
+    m_memory(memory)
+{
+    m_instanceFormat.addAttrib(geom::AttribType::Float, 16, 'M');
+
+    m_stats.numBatches   = 0;
+    m_stats.numInstances = 0;
+}
+
+InstanceBatcher::~InstanceBatcher() {}
+
+void InstanceBatcher::add(mtl::Material* material, const geom::Mesh& mesh, const mat4& transform)
+{
+    if (!material || !mesh.vertices || !mesh.indices)
+        return;
+
+    auto& batch = m_batches[Key(material, mesh.vertices, mesh.indices)];
+
+    batch.mesh = &mesh;
+    batch.transforms.push_back(math::transpose(transform));
+}
+
+void InstanceBatcher::flush(Renderer& renderer)
+{
+    m_stats.numBatches   = 0;
+    m_stats.numInstances = 0;
+
+    for (auto it = m_batches.begin(); it != m_batches.end();)
+    {
+        auto& batch = it->second;
+
+        // Nothing added since the last flush: the keys are plain pointers,
+        // which may already name something else, so the batch goes
+        if (batch.transforms.empty())
+        {
+            it = m_batches.erase(it);
+            continue;
+        }
+
+        auto size = batch.transforms.size() * sizeof(mat4);
+
+        if (!batch.buffer || batch.buffer->size() < size)
+        {
+            // grow geometrically so that a slowly rising count doesn't reallocate every frame
+            auto capacity = batch.buffer ? batch.buffer->size() : 16 * sizeof(mat4);
+
+            while (capacity < size)
+                capacity *= 2;
+
+            batch.buffer = m_memory->allocate(capacity);
+        }
+
+        batch.buffer->write(0, size, &batch.transforms[0]);
+
+        renderer.setActiveMaterial(std::get<0>(it->first));
+        renderer.drawMeshInstanced(*batch.mesh, m_instanceFormat, batch.buffer, (uint) batch.transforms.size());
+
+        ++m_stats.numBatches;
+        m_stats.numInstances += (uint) batch.transforms.size();
+
+        batch.transforms.clear();
+        ++it;
+    }
+}
+
+} // ns gfx
+} // ns mcr
@@ -0,0 +1,234 @@
+#include "Universe.h"
+#include <mcr/gfx/RenderQueue.h>
+
+#include <algorithm>
+#include <mcr/gfx/GpuProfiler.h>
+
+namespace mcr {
+namespace gfx {
+
+//////////////////////////////////////////////////////////////////////////
+// Sort key
+//
+//  opaque:  pass:4 | 0 | render state:17 | program:12 | texture:12 | depth:18
+//  blended: pass:4 | 1 | far-to-near depth:24 | render state:17 | program:12 | texture:6
+
+namespace {
+
+// Non-negative floats order the same as their bit patterns
+inline uint64 depthBits(float depth, uint bits)
+{
+    uint asInt;
+    std::memcpy(&asInt, &depth, sizeof(asInt));
+
+    return asInt >> (31 - bits);
+}
+
+inline uint64 bitField(uint64 value, uint bits, uint shift)
+{
+    return (value & ((uint64(1) << bits) - 1)) << shift;
+}
+
+inline uint firstTexture(const mtl::Material* material)
+{
+    for (byte i = 0; i < material->numTextures(); ++i)
+        if (auto tex = material->texture(i))
+            return tex->handle();
+
+    return 0;
+}
+
+uint64 makeKey(const mtl::Material* material, int pass, float depth)
+{
+    auto key = bitField((uint64) std::max(pass, 0), 4, 60);
+
+    if (material->renderState().blend)
+    {
+        key |= uint64(1) << 59;
+        key |= bitField(~depthBits(depth, 24), 24, 35);
+        key |= bitField(material->renderStateHash(), 17, 18);
+        key |= bitField(material->program(), 12, 6);
+        key |= bitField(firstTexture(material), 6, 0);
+    }
+    else
+    {
+        key |= bitField(material->renderStateHash(), 17, 42);
+        key |= bitField(material->program(), 12, 30);
+        key |= bitField(firstTexture(material), 12, 18);
+        key |= bitField(depthBits(depth, 18), 18, 0);
+    }
+
+    return key;
+}
+
+} // ns
+
+
+//////////////////////////////////////////////////////////////////////////
+// Queue
+
+RenderQueue::RenderQueue():
+    m_culling(false)
+{
+    resetStats();
+}
+
+RenderQueue::~RenderQueue() {}
+
+void RenderQueue::submit(mtl::Material* material, const geom::Mesh& mesh, const mat4& transform, int passHint)
+{
+    if (!material || !mesh.vertices || !mesh.indices)
+        return;
+
+    auto bounds = math::transform(mesh.bounds, transform);
+    auto depth  = math::lengthSq((bounds.isEmpty() ? transform.translation() : bounds.center()) - m_eye);
+
+    Item item =
+    {
+        makeKey(material, passHint < 0 ? material->passHint() : passHint, depth),
+        material,
+        &mesh,
+        transform,
+        bounds,
+        material->findParam("Model")
+    };
+
+    m_items.push_back(item);
+}
+
+void RenderQueue::flush(Renderer& renderer)
+{
+    MCR_PROFILE_SCOPE("RenderQueue::flush");
+    MCR_GPU_PROFILE_SCOPE("RenderQueue::flush");
+
+    m_order.clear();
+
+    if (m_culling)
+    {
+        m_culler.clear();
+        m_visible.clear();
+
+        for (auto it = m_items.begin(); it != m_items.end(); ++it)
+            m_culler.add(it->bounds);
+
+        m_culler.cull(m_frustum, m_visible);
+
+        for (auto it = m_visible.begin(); it != m_visible.end(); ++it)
+            m_order.push_back(&m_items[*it]);
+    }
+    else
+    {
+        for (auto it = m_items.begin(); it != m_items.end(); ++it)
+            m_order.push_back(&*it);
+    }
+
+    Switches naive;
+    _countSwitches(m_order, naive);
+
+    std::stable_sort(m_order.begin(), m_order.end(),
+        [] (const Item* a, const Item* b) { return a->key < b->key; });
+
+    Switches sorted;
+    _countSwitches(m_order, sorted);
+
+    for (auto it = m_order.begin(); it != m_order.end();)
+    {
+        auto& item = **it;
+
+        renderer.setActiveMaterial(item.material);
+
+        if (item.modelParam != -1)
+        {
+            item.material->setParam(item.modelParam, math::transpose(item.transform));
+            item.material->syncParams();
+
+            renderer.drawMesh(*item.mesh);
+            ++it;
+            continue;
+        }
+
+        // Nothing to set per item, so the whole run can go out batched; not
+        // if it's blended though, batches are regrouped by buffer and would
+        // lose the back to front order
+        m_batch.clear();
+
+        for (; it != m_order.end() && (*it)->material == item.material; ++it)
+            m_batch.push_back((*it)->mesh);
+
+        if (m_batch.size() > 1 && !item.material->renderState().blend)
+            renderer.drawMeshBatch(m_batch);
+        else
+        {
+            for (auto mesh = m_batch.begin(); mesh != m_batch.end(); ++mesh)
+                renderer.drawMesh(**mesh);
+        }
+    }
+
+    m_stats.numDraws  += (uint) m_order.size();
+    m_stats.numCulled += (uint) (m_items.size() - m_order.size());
+
+    m_stats.issued.materials    += sorted.materials;
+    m_stats.issued.programs     += sorted.programs;
+    m_stats.issued.textures     += sorted.textures;
+    m_stats.issued.buffers      += sorted.buffers;
+    m_stats.issued.renderStates += sorted.renderStates;
+
+    m_stats.avoided.materials    += naive.materials    - std::min(naive.materials,    sorted.materials);
+    m_stats.avoided.programs     += naive.programs     - std::min(naive.programs,     sorted.programs);
+    m_stats.avoided.textures     += naive.textures     - std::min(naive.textures,     sorted.textures);
+    m_stats.avoided.buffers      += naive.buffers      - std::min(naive.buffers,      sorted.buffers);
+    m_stats.avoided.renderStates += naive.renderStates - std::min(naive.renderStates, sorted.renderStates);
+
+    m_items.clear();
+}
+
+
+//////////////////////////////////////////////////////////////////////////
+// Internals
+
+void RenderQueue::_countSwitches(const std::vector<Item*>& order, Switches& switchesOut)
+{
+    switchesOut = Switches();
+
+    const mtl::Material* material = nullptr;
+    uint program = 0, texture = 0, vbo = 0, ibo = 0, renderState = ~0u;
+
+    for (auto it = order.begin(); it != order.end(); ++it)
+    {
+        auto& item = **it;
+
+        if (item.material != material)
+        {
+            ++switchesOut.materials;
+            material = item.material;
+
+            if (material->program() != program)
+            {
+                ++switchesOut.programs;
+                program = material->program();
+            }
+
+            if (firstTexture(material) != texture)
+            {
+                ++switchesOut.textures;
+                texture = firstTexture(material);
+            }
+
+            if (material->renderStateHash() != renderState)
+            {
+                ++switchesOut.renderStates;
+                renderState = material->renderStateHash();
+            }
+        }
+
+        if (item.mesh->vertices->vbo() != vbo || item.mesh->indices->vbo() != ibo)
+        {
+            ++switchesOut.buffers;
+            vbo = item.mesh->vertices->vbo();
+            ibo = item.mesh->indices->vbo();
+        }
+    }
+}
+
+} // ns gfx
+} // ns mcr
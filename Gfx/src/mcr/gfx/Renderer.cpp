@@ -1,14 +1,81 @@
 #include "Universe.h"
 #include <mcr/gfx/Renderer.h>
 
+#include <algorithm>
+#include <mcr/gfx/GpuProfiler.h>
+#include <mcr/gfx/geom/mem/StreamMemory.h>
 #include "mcr/gfx/GLState.h"
 #include "mcr/gfx/GLEnums.inl"
 
 namespace mcr {
 namespace gfx {
 
+namespace {
+
+geom::mem::StreamMemory& commandMemory()
+{
+    static geom::mem::StreamMemory memory(geom::mem::StreamMemory::Indirect);
+    return memory;
+}
+
+bool batchLess(const geom::Mesh* a, const geom::Mesh* b)
+{
+    if (a->vertices->vbo() != b->vertices->vbo())
+        return a->vertices->vbo() < b->vertices->vbo();
+
+    if (a->indices->vbo() != b->indices->vbo())
+        return a->indices->vbo() < b->indices->vbo();
+
+    if (a->primitiveType != b->primitiveType)
+        return a->primitiveType < b->primitiveType;
+
+    return a->vertexFormat.hash() < b->vertexFormat.hash();
+}
+
+// Meshes pooled in one buffer share a VAO and start at a base vertex, unless
+// their offset isn't a whole number of vertices and has to go in the VAO
+GLint baseVertex(const geom::Mesh& mesh, std::size_t& vertexOffsetOut)
+{
+    auto offset = reinterpret_cast<std::size_t>(mesh.vertices->offset());
+    auto stride = mesh.vertexFormat.stride();
+
+    if (!stride || offset % stride)
+    {
+        vertexOffsetOut = offset;
+        return 0;
+    }
+
+    vertexOffsetOut = 0;
+    return GLint(offset / stride);
+}
+
+uint64 numTriangles(geom::PrimitiveType type, uint numIndices)
+{
+    switch (type)
+    {
+    case geom::PrimitiveType::Triangles:        return numIndices / 3;
+    case geom::PrimitiveType::TriangleStrip:
+    case geom::PrimitiveType::TriangleFan:      return numIndices > 2 ? numIndices - 2 : 0;
+    case geom::PrimitiveType::Quads:            return numIndices / 4 * 2;
+    default:                                    return 0;
+    }
+}
+
+bool sameBatch(const geom::Mesh* a, const geom::Mesh* b)
+{
+    return a->vertices->vbo() == b->vertices->vbo()
+        && a->indices->vbo()  == b->indices->vbo()
+        && a->primitiveType   == b->primitiveType
+        && a->vertexFormat    == b->vertexFormat;
+}
+
+} // ns
+
+
 Renderer::Renderer():
-    m_activeMaterial()
+    m_activeMaterial(),
+    m_frameStats(),
+    m_numCommandBuffers(0)
 {
     *g_glState;
 
@@ -64,9 +131,12 @@ void Renderer::setViewport(const irect& vp)
 
 void Renderer::setRenderState(const mtl::RenderState& rs)
 {
+    auto& stats = g_glState->stats();
+
     if (m_renderState.depthTest != rs.depthTest)
     {
         (rs.depthTest ? glEnable : glDisable)(GL_DEPTH_TEST);
+        ++stats.renderStateChanges;
         m_renderState.depthTest = rs.depthTest;
     }
 
@@ -75,12 +145,14 @@ void Renderer::setRenderState(const mtl::RenderState& rs)
         if (m_renderState.depthFunc != rs.depthFunc)
         {
             glDepthFunc(g_depthFnTable[rs.depthFunc.fn]);
+            ++stats.renderStateChanges;
             m_renderState.depthFunc = rs.depthFunc;
         }
 
         if (m_renderState.depthWrite != rs.depthWrite)
         {
             glDepthMask(rs.depthWrite);
+            ++stats.renderStateChanges;
             m_renderState.depthWrite = rs.depthWrite;
         }
     }
@@ -88,6 +160,7 @@ void Renderer::setRenderState(const mtl::RenderState& rs)
     if (m_renderState.blend != rs.blend)
     {
         (rs.depthTest ? glEnable : glDisable)(GL_BLEND);
+        ++stats.renderStateChanges;
         m_renderState.blend = rs.blend;
     }
 
@@ -95,6 +168,7 @@ void Renderer::setRenderState(const mtl::RenderState& rs)
     {
         glBlendFunc(g_blendFnTable[rs.blendFunc.srcFactor],
                     g_blendFnTable[rs.blendFunc.dstFactor]);
+        ++stats.renderStateChanges;
 
         m_renderState.blendFunc = rs.blendFunc;
     }
@@ -102,18 +176,21 @@ void Renderer::setRenderState(const mtl::RenderState& rs)
     if (m_renderState.alphaTest != rs.alphaTest)
     {
         (rs.alphaTest ? glEnable : glDisable)(GL_SAMPLE_ALPHA_TO_COVERAGE);
+        ++stats.renderStateChanges;
         m_renderState.alphaTest = rs.alphaTest;
     }
 
     if (m_renderState.cullFace != rs.cullFace)
     {
         (rs.cullFace ? glEnable : glDisable)(GL_CULL_FACE);
+        ++stats.renderStateChanges;
         m_renderState.cullFace = rs.cullFace;
     }
 
     if (m_renderState.polygonOffset != rs.polygonOffset)
     {
         (rs.polygonOffset ? glEnable : glDisable)(GL_POLYGON_OFFSET_FILL);
+        ++stats.renderStateChanges;
         m_renderState.polygonOffset = rs.polygonOffset;
     }
 
@@ -134,33 +211,99 @@ void Renderer::setActiveMaterial(mtl::Material* material)
 
 void Renderer::drawMesh(const geom::Mesh& mesh)
 {
-    g_glState->bindBuffer(GL_ARRAY_BUFFER, mesh.vertices->vbo());
-    g_glState->bindBuffer(GL_ELEMENT_ARRAY_BUFFER, mesh.indices->vbo());
+    std::size_t vertexOffset;
+    auto base = baseVertex(mesh, vertexOffset);
+
+    g_glState->bindVertexArray(g_glState->vertexArray(
+        mesh.vertexFormat,
+        mesh.vertices->vbo(),
+        mesh.indices->vbo(),
+        vertexOffset));
+
+    glDrawElementsBaseVertex(g_primitiveTypeTable[mesh.primitiveType], mesh.numIndices(), GL_UNSIGNED_INT,
+                             mesh.indices->offset(), base);
+
+    auto& stats = g_glState->stats();
+    ++stats.numDraws;
+    stats.numTriangles += numTriangles(mesh.primitiveType, mesh.numIndices());
+}
+
+void Renderer::drawMeshInstanced(
+    const geom::Mesh& mesh,
+    const geom::VertexFormat& instanceFormat,
+    const geom::mem::IVideoBuffer* instances,
+    uint numInstances)
+{
+    MCR_PROFILE_SCOPE("Renderer::drawMeshInstanced");
 
-    for (uint i = 0; i < mesh.vertexFormat.numAttribs(); ++i)
+    if (!numInstances)
+        return;
+
+    std::size_t vertexOffset;
+    auto base = baseVertex(mesh, vertexOffset);
+
+    g_glState->bindVertexArray(g_glState->vertexArray(
+        mesh.vertexFormat,
+        mesh.vertices->vbo(),
+        mesh.indices->vbo(),
+        vertexOffset,
+        &instanceFormat,
+        instances->vbo(),
+        reinterpret_cast<std::size_t>(instances->offset())));
+
+    glDrawElementsInstancedBaseVertex(g_primitiveTypeTable[mesh.primitiveType], mesh.numIndices(), GL_UNSIGNED_INT,
+                                      mesh.indices->offset(), (GLsizei) numInstances, base);
+
+    auto& stats = g_glState->stats();
+    ++stats.numDraws;
+    stats.numTriangles += numTriangles(mesh.primitiveType, mesh.numIndices()) * numInstances;
+}
+
+uint Renderer::drawMeshBatch(const std::vector<const geom::Mesh*>& meshes)
+{
+    MCR_PROFILE_SCOPE("Renderer::drawMeshBatch");
+
+    uint numCalls = 0;
+    m_batch.clear();
+
+    for (auto it = meshes.begin(); it != meshes.end(); ++it)
     {
-        auto& attrib = mesh.vertexFormat.attrib(i);
+        auto& mesh = **it;
 
-        if (attrib.length)
+        // A base vertex can't express an offset that's not a whole number of vertices
+        if (reinterpret_cast<std::size_t>(mesh.vertices->offset()) % mesh.vertexFormat.stride())
         {
-            glEnableVertexAttribArray(i);
-            glVertexAttribPointer(i,
-                attrib.length, g_attribTypeTable[attrib.type], GL_FALSE,
-                mesh.vertexFormat.stride(), reinterpret_cast<const GLvoid*> 
-					(reinterpret_cast<std::size_t>(mesh.vertices->offset()) 
-					 + attrib.offset));
+            drawMesh(mesh);
+            ++numCalls;
         }
         else
-        {
-            glDisableVertexAttribArray(i);
-        }
+            m_batch.push_back(&mesh);
     }
 
-    glDrawElements(g_primitiveTypeTable[mesh.primitiveType], mesh.numIndices(), GL_UNSIGNED_INT, mesh.indices->offset());
+    std::sort(m_batch.begin(), m_batch.end(), batchLess);
+
+    for (std::size_t begin = 0, end = 1; begin < m_batch.size(); ++end)
+    {
+        if (end < m_batch.size() && sameBatch(m_batch[begin], m_batch[end]))
+            continue;
+
+        if (end - begin == 1)
+            drawMesh(*m_batch[begin]);
+        else
+            _multiDraw(m_batch, begin, end);
+
+        ++numCalls;
+        begin = end;
+    }
+
+    return numCalls;
 }
 
 void Renderer::clear()
 {
+    MCR_PROFILE_SCOPE("Renderer::clear");
+    MCR_GPU_PROFILE_SCOPE("Renderer::clear");
+
     if (!m_renderState.depthTest)
         glEnable(GL_DEPTH_TEST);
 
@@ -176,6 +319,19 @@ void Renderer::clear()
         glDisable(GL_DEPTH_TEST);
 }
 
+void Renderer::endFrame()
+{
+    MCR_PROFILE_SCOPE("Renderer::endFrame");
+
+    geom::mem::StreamMemory::endFrame();
+    GpuProfiler::instance().endFrame();
+
+    m_frameStats = g_glState->stats();
+    g_glState->stats() = RenderStats();
+
+    m_numCommandBuffers = 0;
+}
+
 void Renderer::readFrontBuffer(const irect& area, vec4* pixelsOut) const
 {
     glReadPixels(area.left(), area.bottom(), area.width(), area.height(), GL_RGBA, GL_FLOAT, pixelsOut);
@@ -191,5 +347,81 @@ void Renderer::readFrontBuffer(const irect& area, u16vec4* pixelsOut) const
     glReadPixels(area.left(), area.bottom(), area.width(), area.height(), GL_RGBA, GL_UNSIGNED_SHORT, pixelsOut);
 }
 
+
+//////////////////////////////////////////////////////////////////////////
+// Internals
+
+void Renderer::_multiDraw(const std::vector<const geom::Mesh*>& meshes, std::size_t begin, std::size_t end)
+{
+    auto& first = *meshes[begin];
+    auto count  = end - begin;
+    auto stride = first.vertexFormat.stride();
+    auto mode   = g_primitiveTypeTable[first.primitiveType];
+
+    // Vertices are addressed from the start of the buffer, the offsets go to base vertices
+    g_glState->bindVertexArray(g_glState->vertexArray(
+        first.vertexFormat,
+        first.vertices->vbo(),
+        first.indices->vbo(),
+        0));
+
+    m_commands.resize(count);
+
+    auto& stats = g_glState->stats();
+    ++stats.numDraws;
+
+    for (std::size_t i = 0; i < count; ++i)
+    {
+        auto& mesh = *meshes[begin + i];
+        auto& cmd  = m_commands[i];
+
+        stats.numTriangles += numTriangles(mesh.primitiveType, mesh.numIndices());
+
+        cmd.count         = mesh.numIndices();
+        cmd.instanceCount = 1;
+        cmd.firstIndex    = uint(reinterpret_cast<std::size_t>(mesh.indices->offset()) / sizeof(uint));
+        cmd.baseVertex    = int(reinterpret_cast<std::size_t>(mesh.vertices->offset()) / stride);
+        cmd.baseInstance  = 0;
+    }
+
+    if (GLEW_ARB_multi_draw_indirect)
+    {
+        auto size = count * sizeof(DrawCommand);
+
+        // Rewriting a stream buffer within the frame would run out of regions
+        // and wait on the GPU, so every multi-draw gets a buffer of its own
+        if (m_numCommandBuffers == m_commandBuffers.size())
+            m_commandBuffers.push_back(nullptr);
+
+        auto& buffer = m_commandBuffers[m_numCommandBuffers++];
+
+        if (!buffer || buffer->size() < size)
+        {
+            auto capacity = buffer ? std::max(size, 2 * buffer->size()) : size;
+            buffer = commandMemory().allocate(capacity);
+        }
+
+        buffer->write(0, size, &m_commands[0]);
+
+        g_glState->bindBuffer(GL_DRAW_INDIRECT_BUFFER, buffer->vbo());
+        glMultiDrawElementsIndirect(mode, GL_UNSIGNED_INT, buffer->offset(), (GLsizei) count, 0);
+    }
+    else
+    {
+        std::vector<GLsizei>     counts(count);
+        std::vector<const void*> offsets(count);
+        std::vector<GLint>       baseVertices(count);
+
+        for (std::size_t i = 0; i < count; ++i)
+        {
+            counts[i]       = (GLsizei) m_commands[i].count;
+            offsets[i]      = meshes[begin + i]->indices->offset();
+            baseVertices[i] = m_commands[i].baseVertex;
+        }
+
+        glMultiDrawElementsBaseVertex(mode, &counts[0], GL_UNSIGNED_INT, &offsets[0], (GLsizei) count, &baseVertices[0]);
+    }
+}
+
 } // ns gfx
 } // ns mcr
@@ -2,17 +2,97 @@
 #include <mcr/gfx/geom/Mesh.h>
 
 #include <fstream>
+#include <vector>
+#include <mcr/Log.h>
+#include <mcr/Profiler.h>
+#include <mcr/Timer.h>
 #include <SimpleMesh4.h>
 
 namespace mcr  {
 namespace gfx  {
 namespace geom {
 
+namespace {
+
+// Fill a video buffer with \c size bytes at \c pos, writing each byte
+// to GPU-visible memory exactly once
+std::size_t streamToBuffer(io::IFileReader* stream, uint64 pos, std::size_t size, mem::IVideoBuffer* dst)
+{
+    if (auto mapped = static_cast<const byte*>(stream->data()))
+    {
+        if (pos + size > stream->size())
+            return 0;
+
+        dst->write(0, size, mapped + pos);
+        stream->seek(pos + size);
+
+        return size;
+    }
+
+    stream->seek(pos);
+
+    if (auto ptr = dst->map(0, size))
+    {
+        auto read = stream->read(ptr, size);
+        return dst->unmap() ? read : 0;
+    }
+
+    // can't map the buffer, so take the long way
+    auto buffer = new byte[size];
+
+    auto read = stream->read(buffer, size);
+    dst->write(0, read, buffer);
+
+    delete [] buffer;
+
+    return read;
+}
+
+// Box and sphere around the positions, taken to be the first attribute
+void computeBounds(const byte* vertices, uint numVertices, const VertexFormat& fmt, bbox& boxOut, sphere& sphereOut)
+{
+    boxOut    = bbox();
+    sphereOut = sphere();
+
+    if (!fmt.numAttribs() || fmt.attrib(0).type != AttribType::Float || fmt.attrib(0).length < 3)
+        return;
+
+    const std::size_t stride = fmt.stride(), offset = fmt.attrib(0).offset;
+
+    auto position = [&] (uint i) -> vec3
+    {
+        float pos[3];
+        std::memcpy(pos, vertices + i * stride + offset, sizeof(pos));
+        return vec3(pos[0], pos[1], pos[2]);
+    };
+
+    for (uint i = 0; i < numVertices; ++i)
+        boxOut.add(position(i));
+
+    if (boxOut.isEmpty())
+        return;
+
+    // Centered on the box, this is tighter than the box's own bounding sphere
+    auto center = boxOut.center();
+    float radiusSq = 0;
+
+    for (uint i = 0; i < numVertices; ++i)
+        radiusSq = std::max(radiusSq, math::lengthSq(position(i) - center));
+
+    sphereOut = sphere(center, std::sqrt(radiusSq));
+}
+
+} // ns
+
 bool Mesh::load(io::IFileReader* stream, mem::IVideoMemory* vertMem, mem::IVideoMemory* idxMem, Mesh& meshOut)
 {
+    MCR_PROFILE_SCOPE("Mesh::load");
+
     if (!stream)
         return false;
 
+    Timer timer;
+
     auto startPos = stream->tell();
 
     SimpleMesh::Header header;
@@ -33,43 +113,90 @@ bool Mesh::load(io::IFileReader* stream, mem::IVideoMemory* vertMem, mem::IVideo
 
     VertexFormat fmt;
 
-    auto attribs = new SimpleMesh::VertexAttribute[header.numAttributes];
-
     stream->seek(startPos + header.attributeDataOffset);
-    read += stream->read(attribs, header.numAttributes);
 
     for (uint i = 0; i < header.numAttributes; ++i)
-        fmt.addAttrib(AttribType(AttribType::SByte + attribs[i].type), attribs[i].length); // sic!
-
-    delete [] attribs;
+    {
+        SimpleMesh::VertexAttribute attrib;
+        read += stream->read(attrib);
 
+        fmt.addAttrib(AttribType(AttribType::SByte + attrib.type), attrib.length); // sic!
+    }
 
-    auto vertices = new byte[vertexDataSize];
-    auto indices  = new uint[header.numIndices];
 
-    stream->seek(startPos + header.vertexDataOffset);
-    read += stream->read(vertices, vertexDataSize);
+    // Stride-aligned vertices let pooled meshes be drawn with a base vertex
+    auto vertices = vertMem->allocate(vertexDataSize, fmt.stride());
+    auto indices  = idxMem->allocate(indexDataSize, sizeof(uint));
 
-    stream->seek(startPos + header.indexDataOffset);
-    read += stream->read(indices, header.numIndices);
+    // The bounds need the vertices on the CPU: use the stream's memory if it
+    // has some, otherwise go through a temporary rather than reading back
+    std::vector<byte> vertexData;
+    const byte* vertexBytes;
 
-    bool success = read == sizeof(header) + attribDataSize + vertexDataSize + indexDataSize;
-    if (success)
+    if (auto mapped = static_cast<const byte*>(stream->data()))
+    {
+        read += streamToBuffer(stream, startPos + header.vertexDataOffset, vertexDataSize, vertices);
+        vertexBytes = mapped + startPos + header.vertexDataOffset;
+    }
+    else
     {
-        meshOut.vertices = vertMem->allocate(vertexDataSize);
-        meshOut.indices  = idxMem->allocate(indexDataSize);
+        vertexData.resize(vertexDataSize);
 
-        meshOut.vertices->write(0, vertexDataSize, vertices);
-        meshOut.indices->write(0, indexDataSize, indices);
+        stream->seek(startPos + header.vertexDataOffset);
+        auto vertexRead = stream->read(vertexData.data(), vertexDataSize);
+        vertices->write(0, vertexRead, vertexData.data());
 
-        meshOut.vertexFormat  = fmt;
-        meshOut.primitiveType = PrimitiveType::Triangles;
+        read += vertexRead;
+        vertexBytes = vertexData.data();
     }
 
-    delete [] indices;
-    delete [] vertices;
+    read += streamToBuffer(stream, startPos + header.indexDataOffset, indexDataSize, indices);
+
+    if (read != sizeof(header) + attribDataSize + vertexDataSize + indexDataSize)
+        return false;
+
+    computeBounds(vertexBytes, header.numVertices, fmt, meshOut.bounds, meshOut.boundingSphere);
+
+    meshOut.vertices      = vertices;
+    meshOut.indices       = indices;
+    meshOut.vertexFormat  = fmt;
+    meshOut.primitiveType = PrimitiveType::Triangles;
+
+    timer.refresh();
+
+    const std::size_t bytes = vertexDataSize + indexDataSize;
+
+    g_log->debug("Mesh %s: %u bytes in %.3f ms (%.1f MB/s)",
+        stream->filename(), (uint) bytes, 1000.0 * timer.seconds(),
+        timer.seconds() > 0 ? bytes / (1048576.0 * timer.seconds()) : 0.0);
+
+    return true;
+}
+
+bool Mesh::check(io::IFileReader* stream)
+{
+    if (!stream)
+        return false;
+
+    auto startPos = stream->tell();
+
+    SimpleMesh::Header header;
+    auto read = stream->read(header);
+
+    stream->seek(startPos);
+
+    if (read != sizeof(header) || !header.checkSignature() || header.version != SIMPLE_MESH_VERSION)
+        return false;
+
+    const uint64
+        size           = stream->size() - startPos,
+        attribDataSize = header.numAttributes * sizeof(SimpleMesh::VertexAttribute),
+        vertexDataSize = (uint64) header.numVertices * header.vertexSize,
+        indexDataSize  = (uint64) header.numIndices * sizeof(uint);
 
-    return success;
+    return header.attributeDataOffset + attribDataSize <= size
+        && header.vertexDataOffset    + vertexDataSize <= size
+        && header.indexDataOffset     + indexDataSize  <= size;
 }
 
 bool Mesh::save(io::IWriter* stream, const Mesh& mesh)
@@ -19,7 +19,7 @@ NaiveMemory::Buffer::Buffer(const NaiveMemory* memory, std::size_t size):
 
 NaiveMemory::Buffer::~Buffer()
 {
-    glDeleteBuffers(1, &m_vbo);
+    g_glState->deleteBuffer(m_vbo);
 }
 
 void NaiveMemory::Buffer::read(std::size_t offset, std::size_t length, void* dst) const
@@ -31,18 +31,37 @@ void NaiveMemory::Buffer::read(std::size_t offset, std::size_t length, void* dst
 
 void NaiveMemory::Buffer::write(std::size_t offset, std::size_t length, const void* src)
 {
+    g_glState->stats().bufferBytes += length;
+
     g_glState->bindVertexArray(0);
     g_glState->bindBuffer(m_memory->m_target, m_vbo);
     glBufferSubData(m_memory->m_target, (GLintptr) offset, (GLsizeiptr) length, src);
 }
 
+void* NaiveMemory::Buffer::map(std::size_t offset, std::size_t length)
+{
+    g_glState->stats().bufferBytes += length;
+
+    g_glState->bindVertexArray(0);
+    g_glState->bindBuffer(m_memory->m_target, m_vbo);
+    return glMapBufferRange(m_memory->m_target, (GLintptr) offset, (GLsizeiptr) length,
+                            GL_MAP_WRITE_BIT | GL_MAP_INVALIDATE_RANGE_BIT);
+}
+
+bool NaiveMemory::Buffer::unmap()
+{
+    g_glState->bindVertexArray(0);
+    g_glState->bindBuffer(m_memory->m_target, m_vbo);
+    return glUnmapBuffer(m_memory->m_target) == GL_TRUE;
+}
+
 NaiveMemory::NaiveMemory(Target target, Usage usage)
 {
     m_target = target == Index ? GL_ELEMENT_ARRAY_BUFFER : GL_ARRAY_BUFFER;
     m_usage  = usage  == Static ? GL_STATIC_DRAW : GL_DYNAMIC_DRAW;
 }
 
-rcptr<IVideoBuffer> NaiveMemory::allocate(std::size_t size)
+rcptr<IVideoBuffer> NaiveMemory::allocate(std::size_t size, std::size_t)
 {
     return new Buffer(this, size);
 }
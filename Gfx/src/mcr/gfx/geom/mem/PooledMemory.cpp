@@ -0,0 +1,223 @@
+#include "Universe.h"
+#include <mcr/gfx/geom/mem/PooledMemory.h>
+
+#include <algorithm>
+#include "mcr/gfx/GLState.h"
+
+namespace mcr  {
+namespace gfx  {
+namespace geom {
+namespace mem  {
+
+namespace {
+
+//! What an allocation of \c size takes up in its page
+std::size_t alignedSize(std::size_t size)
+{
+    return (std::max<std::size_t>(size, 1u) + PooledMemory::Alignment - 1) & ~std::size_t(PooledMemory::Alignment - 1);
+}
+
+} // ns
+
+
+//////////////////////////////////////////////////////////////////////////
+// Buffer
+
+PooledMemory::Buffer::Buffer(PooledMemory* memory, Page* page, std::size_t offset, std::size_t size):
+    m_memory(memory), m_page(page),
+    m_offset(offset), m_size(size) {}
+
+PooledMemory::Buffer::~Buffer()
+{
+    m_memory->_release(m_page, m_offset, alignedSize(m_size));
+}
+
+void PooledMemory::Buffer::read(std::size_t offset, std::size_t length, void* dst) const
+{
+    g_glState->bindVertexArray(0);
+    g_glState->bindBuffer(m_memory->m_target, m_page->vbo);
+    glGetBufferSubData(m_memory->m_target, (GLintptr) (m_offset + offset), (GLsizeiptr) length, dst);
+}
+
+void PooledMemory::Buffer::write(std::size_t offset, std::size_t length, const void* src)
+{
+    g_glState->stats().bufferBytes += length;
+
+    g_glState->bindVertexArray(0);
+    g_glState->bindBuffer(m_memory->m_target, m_page->vbo);
+    glBufferSubData(m_memory->m_target, (GLintptr) (m_offset + offset), (GLsizeiptr) length, src);
+}
+
+void* PooledMemory::Buffer::map(std::size_t offset, std::size_t length)
+{
+    g_glState->stats().bufferBytes += length;
+
+    g_glState->bindVertexArray(0);
+    g_glState->bindBuffer(m_memory->m_target, m_page->vbo);
+    return glMapBufferRange(m_memory->m_target, (GLintptr) (m_offset + offset), (GLsizeiptr) length,
+                            GL_MAP_WRITE_BIT | GL_MAP_INVALIDATE_RANGE_BIT);
+}
+
+bool PooledMemory::Buffer::unmap()
+{
+    g_glState->bindVertexArray(0);
+    g_glState->bindBuffer(m_memory->m_target, m_page->vbo);
+    return glUnmapBuffer(m_memory->m_target) == GL_TRUE;
+}
+
+
+//////////////////////////////////////////////////////////////////////////
+// Memory
+
+PooledMemory::PooledMemory(Target target, Usage usage, std::size_t pageSize):
+    m_pageSize(pageSize)
+{
+    m_target = target == Index ? GL_ELEMENT_ARRAY_BUFFER : GL_ARRAY_BUFFER;
+    m_usage  = usage  == Static ? GL_STATIC_DRAW : GL_DYNAMIC_DRAW;
+}
+
+PooledMemory::~PooledMemory()
+{
+    for (auto it = m_pages.begin(); it != m_pages.end(); ++it)
+    {
+        g_glState->deleteBuffer((*it)->vbo);
+        delete *it;
+    }
+}
+
+rcptr<IVideoBuffer> PooledMemory::allocate(std::size_t size, std::size_t alignment)
+{
+    auto blockSize = alignedSize(size);
+
+    // Offsets keep to the default alignment unless asked otherwise,
+    // the requested one needn't be a power of two
+    if (alignment <= 1)
+        alignment = Alignment;
+
+    for (;;)
+    {
+        for (auto pageIt = m_pages.begin(); pageIt != m_pages.end(); ++pageIt)
+        {
+            auto page = *pageIt;
+
+            for (auto it = page->freeBlocks.begin(); it != page->freeBlocks.end(); ++it)
+            {
+                auto freeOffset = it->first, freeSize = it->second;
+
+                auto offset  = (freeOffset + alignment - 1) / alignment * alignment;
+                auto padding = offset - freeOffset;
+
+                if (freeSize < padding + blockSize)
+                    continue;
+
+                auto rest = freeSize - padding - blockSize;
+
+                page->freeBlocks.erase(it);
+
+                if (padding)
+                    page->freeBlocks[freeOffset] = padding;
+
+                if (rest)
+                    page->freeBlocks[offset + blockSize] = rest;
+
+                ++page->numAllocations;
+
+                return new Buffer(this, page, offset, size);
+            }
+        }
+
+        // Nothing fits, so add a page; oversized requests get one of their own
+        _createPage(std::max<std::size_t>(m_pageSize, blockSize + alignment));
+    }
+}
+
+PooledMemory::Stats PooledMemory::stats() const
+{
+    Stats stats = {};
+
+    stats.numPages = m_pages.size();
+
+    for (auto pageIt = m_pages.begin(); pageIt != m_pages.end(); ++pageIt)
+    {
+        auto page = *pageIt;
+
+        stats.numAllocations += page->numAllocations;
+        stats.bytesReserved  += page->size;
+        stats.bytesUsed      += page->size;
+        stats.numFreeBlocks  += page->freeBlocks.size();
+
+        for (auto it = page->freeBlocks.begin(); it != page->freeBlocks.end(); ++it)
+        {
+            stats.bytesUsed -= it->second;
+            stats.largestFreeBlock = std::max(stats.largestFreeBlock, it->second);
+        }
+    }
+
+    return stats;
+}
+
+
+//////////////////////////////////////////////////////////////////////////
+// Internals
+
+PooledMemory::Page* PooledMemory::_createPage(std::size_t size)
+{
+    auto page = new Page;
+
+    page->size = size;
+    page->numAllocations = 0;
+    page->freeBlocks[0] = size;
+
+    glGenBuffers(1, &page->vbo);
+    g_glState->bindVertexArray(0);
+    g_glState->bindBuffer(m_target, page->vbo);
+    glBufferData(m_target, (GLsizeiptr) size, nullptr, m_usage);
+
+    m_pages.push_back(page);
+
+    return page;
+}
+
+void PooledMemory::_release(Page* page, std::size_t offset, std::size_t size)
+{
+    auto& blocks = page->freeBlocks;
+
+    auto next = blocks.lower_bound(offset);
+
+    // merge with the following block
+    if (next != blocks.end() && offset + size == next->first)
+    {
+        size += next->second;
+        next = blocks.erase(next);
+    }
+
+    // and with the preceding one
+    if (next != blocks.begin())
+    {
+        auto prev = next;
+        --prev;
+
+        if (prev->first + prev->second == offset)
+        {
+            offset = prev->first;
+            size  += prev->second;
+            blocks.erase(prev);
+        }
+    }
+
+    blocks[offset] = size;
+
+    // Keep one page around, but give back any other one that empties out
+    if (!--page->numAllocations && m_pages.size() > 1)
+    {
+        m_pages.erase(std::find(m_pages.begin(), m_pages.end(), page));
+
+        g_glState->deleteBuffer(page->vbo);
+        delete page;
+    }
+}
+
+} // ns mem
+} // ns geom
+} // ns gfx
+} // ns mcr
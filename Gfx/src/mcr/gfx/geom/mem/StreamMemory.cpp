@@ -0,0 +1,224 @@
+#include "Universe.h"
+#include <mcr/gfx/geom/mem/StreamMemory.h>
+
+#include <algorithm>
+#include <deque>
+#include "mcr/gfx/GLState.h"
+
+namespace mcr  {
+namespace gfx  {
+namespace geom {
+namespace mem  {
+
+//////////////////////////////////////////////////////////////////////////
+// Frame fences
+
+namespace {
+
+struct FrameFence
+{
+    uint64 frame;
+    GLsync sync;
+};
+
+uint64 g_frame = 1, g_retiredFrame = 0;
+std::deque<FrameFence> g_fences;
+
+void waitSync(GLsync sync)
+{
+    GLbitfield flags = GL_SYNC_FLUSH_COMMANDS_BIT;
+
+    while (glClientWaitSync(sync, flags, 1000000000ull) == GL_TIMEOUT_EXPIRED)
+        flags = 0;
+}
+
+std::size_t gcd(std::size_t a, std::size_t b)
+{
+    while (b)
+    {
+        auto rest = a % b;
+        a = b;
+        b = rest;
+    }
+
+    return a;
+}
+
+// Block until the GPU is done with everything up to \c frame
+void retireFrame(uint64 frame)
+{
+    if (frame <= g_retiredFrame)
+        return;
+
+    if (frame == g_frame)
+    {
+        // Still being recorded, so fence it right here. Only happens
+        // when one buffer is rewritten more often than there are regions.
+        auto sync = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+        waitSync(sync);
+        glDeleteSync(sync);
+
+        frame = g_frame - 1;
+    }
+
+    while (!g_fences.empty() && g_fences.front().frame <= frame)
+    {
+        waitSync(g_fences.front().sync);
+        glDeleteSync(g_fences.front().sync);
+
+        g_retiredFrame = g_fences.front().frame;
+        g_fences.pop_front();
+    }
+
+    g_retiredFrame = std::max(g_retiredFrame, frame);
+}
+
+} // ns
+
+void StreamMemory::endFrame()
+{
+    FrameFence fence = {g_frame++, glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0)};
+    g_fences.push_back(fence);
+
+    // Retire whatever's already done without blocking
+    while (!g_fences.empty() && glClientWaitSync(g_fences.front().sync, 0, 0) != GL_TIMEOUT_EXPIRED)
+    {
+        glDeleteSync(g_fences.front().sync);
+
+        g_retiredFrame = g_fences.front().frame;
+        g_fences.pop_front();
+    }
+}
+
+
+//////////////////////////////////////////////////////////////////////////
+// Buffer
+
+StreamMemory::Buffer::Buffer(const StreamMemory* memory, std::size_t size, std::size_t alignment):
+    m_memory(memory),
+    m_shadow(size),
+    m_region(0),
+    m_mapping()
+{
+    // Regions start at multiples of both the caller's and the target's alignment
+    auto a = memory->m_alignment, b = std::max<std::size_t>(alignment, 1u);
+    auto unit = a / gcd(a, b) * b;
+
+    m_regionSize = (std::max<std::size_t>(size, 1u) + unit - 1) / unit * unit;
+
+    for (uint i = 0; i < NumRegions; ++i)
+        m_regionFrames[i] = 0;
+
+    glGenBuffers(1, &m_vbo);
+    g_glState->bindVertexArray(0);
+    g_glState->bindBuffer(memory->m_target, m_vbo);
+
+    if (memory->m_persistent)
+    {
+        const GLbitfield flags = GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT;
+
+        glBufferStorage(memory->m_target, (GLsizeiptr) (NumRegions * m_regionSize), nullptr, flags);
+        m_mapping = static_cast<byte*>(glMapBufferRange(memory->m_target, 0, (GLsizeiptr) (NumRegions * m_regionSize), flags));
+    }
+    else
+        glBufferData(memory->m_target, (GLsizeiptr) m_regionSize, nullptr, GL_STREAM_DRAW);
+}
+
+StreamMemory::Buffer::~Buffer()
+{
+    if (m_mapping)
+    {
+        g_glState->bindVertexArray(0);
+        g_glState->bindBuffer(m_memory->m_target, m_vbo);
+        glUnmapBuffer(m_memory->m_target);
+    }
+
+    g_glState->deleteBuffer(m_vbo);
+}
+
+void StreamMemory::Buffer::read(std::size_t offset, std::size_t length, void* dst) const
+{
+    std::memcpy(dst, &m_shadow[offset], length);
+}
+
+void StreamMemory::Buffer::write(std::size_t offset, std::size_t length, const void* src)
+{
+    std::memcpy(&m_shadow[offset], src, length);
+    _push();
+}
+
+void* StreamMemory::Buffer::map(std::size_t offset, std::size_t length)
+{
+    return &m_shadow[offset];
+}
+
+bool StreamMemory::Buffer::unmap()
+{
+    _push();
+    return true;
+}
+
+void StreamMemory::Buffer::_push()
+{
+    if (m_shadow.empty())
+        return;
+
+    // All of it goes out whatever part was written
+    g_glState->stats().bufferBytes += m_shadow.size();
+
+    if (!m_mapping)
+    {
+        // orphan the old storage, the driver can hand us a fresh one
+        g_glState->bindVertexArray(0);
+        g_glState->bindBuffer(m_memory->m_target, m_vbo);
+        glBufferData(m_memory->m_target, (GLsizeiptr) m_regionSize, nullptr, GL_STREAM_DRAW);
+        glBufferSubData(m_memory->m_target, 0, (GLsizeiptr) m_shadow.size(), &m_shadow[0]);
+        return;
+    }
+
+    // The current region may have been drawn from during this frame
+    m_regionFrames[m_region] = g_frame;
+    m_region = (m_region + 1) % NumRegions;
+
+    retireFrame(m_regionFrames[m_region]);
+
+    std::memcpy(m_mapping + m_region * m_regionSize, &m_shadow[0], m_shadow.size());
+}
+
+
+//////////////////////////////////////////////////////////////////////////
+// Memory
+
+StreamMemory::StreamMemory(Target target):
+    m_alignment(16)
+{
+    *g_glState;
+
+    m_persistent = GLEW_ARB_buffer_storage != GL_FALSE;
+
+    switch (target)
+    {
+    case Vertex:   m_target = GL_ARRAY_BUFFER;         break;
+    case Index:    m_target = GL_ELEMENT_ARRAY_BUFFER; break;
+    case Indirect: m_target = GL_DRAW_INDIRECT_BUFFER; break;
+    case Uniform:  m_target = GL_UNIFORM_BUFFER;
+        {
+            GLint alignment = 0;
+            glGetIntegerv(GL_UNIFORM_BUFFER_OFFSET_ALIGNMENT, &alignment);
+
+            if (alignment > (GLint) m_alignment)
+                m_alignment = (std::size_t) alignment;
+        }
+        break;
+    }
+}
+
+rcptr<IVideoBuffer> StreamMemory::allocate(std::size_t size, std::size_t alignment)
+{
+    return new Buffer(this, size, alignment);
+}
+
+} // ns mem
+} // ns geom
+} // ns gfx
+} // ns mcr
@@ -2,8 +2,13 @@
 #include <mcr/gfx/mtl/Manager.h>
 
 #include <istream>
+#include <thread>
+#include <mcr/Log.h>
+#include <mcr/Profiler.h>
 #include <mcr/io/LineParser.h>
+#include <mcr/io/MemoryReader.h>
 #include "ShaderPreprocessor.h"
+#include "MaterialCache.h"
 
 // TODO: rethink, rewrite
 
@@ -11,16 +16,33 @@ namespace mcr {
 namespace gfx {
 namespace mtl {
 
+namespace {
+
+uint64 hashSources(const std::vector<std::string>& sources)
+{
+    auto hash = MaterialCache::hash(nullptr, 0);
+
+    for (auto it = sources.begin(); it != sources.end(); ++it)
+        hash = MaterialCache::hash(it->data(), it->size() + 1, hash); // with the terminator, to keep them apart
+
+    return hash;
+}
+
+} // ns
+
+
 //////////////////////////////////////////////////////////////////////////
 // Init
 
 void Manager::_init()
 {
     m_preprocessor = new ShaderPreprocessor(this);
+    m_compileTimer.start();
 }
 
 void Manager::_destroy()
 {
+    delete m_cache;
     delete m_preprocessor;
 }
 
@@ -49,41 +71,72 @@ Manager::TextureData::~TextureData() {}
 
 Texture* Manager::getTexture(const std::string& filename)
 {
-    auto file = m_fs->openReader(filename.c_str());
-    if (!file)
-        return nullptr;
+    MCR_PROFILE_SCOPE("Manager::getTexture");
+
+    auto it = m_tex.textures.find(filename);
+    if (it != m_tex.textures.end() && it->second)
+        return it->second;
 
-    auto& tex = m_tex.textures[filename];
-    if (!tex)
+    if (m_loader)
     {
-        tex = Texture::create();
-        tex->load(file);
+        auto tex = Texture::create();
+
+        m_tex.textures[filename] = tex;
+        m_loader->loadTexture(filename.c_str(), tex);
+
+        return tex;
     }
 
+    auto file = _openReader(filename, true);
+    if (!file)
+        return nullptr;
+
+    auto tex = Texture::create();
+
+    m_tex.textures[filename] = tex;
+    tex->load(file);
+
     return tex;
 }
 
 Shader* Manager::getShader(const std::string& filename)
 {
-    auto file = m_fs->openReader(filename.c_str(), false);
+    MCR_PROFILE_SCOPE("Manager::getShader");
+
+    auto it = m_shaders.find(filename);
+    if (it != m_shaders.end() && it->second)
+        return it->second;
+
+    auto file = _openReader(filename, false);
     if (!file)
         return nullptr;
 
-    auto& shader = m_shaders[filename];
-    if (!shader)
+    auto type = Shader::Vertex;
+
+    switch (io::Path::ext(filename.c_str())[0])
     {
-        auto type = Shader::Vertex;
-    
-        switch (io::Path::ext(file->filename())[0])
-        {
-        case 'g': type = Shader::Geometry; break;
-        case 'f': type = Shader::Fragment;
-        }
+    case 'g': type = Shader::Geometry; break;
+    case 'f': type = Shader::Fragment;
+    }
+
+    auto shader = Shader::create(type);
+    m_shaders[filename] = shader;
+
+    m_compileTimer.refresh();
+    auto submitted = m_compileTimer.microseconds();
 
-        shader = Shader::create(type);
+    shader->setPreprocessor(m_preprocessor);
+    shader->setSourceFromStream(file);
 
-        shader->setPreprocessor(m_preprocessor);
-        shader->setSourceFromStream(file);
+    if (m_batching)
+    {
+        PendingShader pending = {shader, filename, submitted};
+        m_pendingShaders.push_back(pending);
+    }
+    else
+    {
+        shader->isValid();
+        _addCompileTiming(filename, submitted);
     }
 
     return shader;
@@ -91,18 +144,292 @@ Shader* Manager::getShader(const std::string& filename)
 
 Material* Manager::getMaterial(const std::string& filename)
 {
-    auto file = m_fs->openReader(filename.c_str(), false);
+    MCR_PROFILE_SCOPE("Manager::getMaterial");
+
+    auto it = m_materials.find(filename);
+    if (it != m_materials.end() && it->second)
+        return it->second;
+
+    auto file = _openReader(filename, false);
     if (!file)
         return nullptr;
 
-    auto& material = m_materials[filename];
-    if (!material)
+    auto material = Material::create(this);
+
+    m_materials[filename] = material;
+    _loadMaterial(material, file);
+
+    return material;
+}
+
+void Manager::prefetch(const std::vector<std::string>& filenames)
+{
+    MCR_PROFILE_SCOPE("Manager::prefetch");
+
+    for (auto it = filenames.begin(); it != filenames.end(); ++it)
+    {
+        Name name(*it);
+
+        if (m_prefetched.find(name) != m_prefetched.end() || m_missing.find(name) != m_missing.end())
+            continue;
+
+        if (m_tex.textures.find(name) != m_tex.textures.end()
+        ||  m_shaders.find(name)      != m_shaders.end()
+        ||  m_materials.find(name)    != m_materials.end())
+            continue;
+
+        // Binary, so that it's mapped rather than read where possible
+        if (auto file = io::MemoryReader::fromFile(m_fs->openReader(it->c_str())))
+            m_prefetched[name] = file;
+        else
+            m_missing[name] = true;
+    }
+}
+
+AsyncLoader::Ticket Manager::loadMaterial(const std::string& filename, rcptr<Material>& materialOut)
+{
+    auto it = m_materials.find(filename);
+    if (it != m_materials.end() || !m_loader)
+    {
+        std::promise<bool> result;
+
+        if (it != m_materials.end())
+            materialOut = it->second;
+
+        result.set_value(it != m_materials.end());
+        return result.get_future().share();
+    }
+
+    auto materialPtr = &materialOut;
+
+    return m_loader->load(filename.c_str(), false, nullptr,
+        [=] (io::IFileReader* file) -> bool
+        {
+            auto& material = m_materials[filename];
+            if (!material) // could have been loaded meanwhile
+            {
+                material = Material::create(this);
+                _loadMaterial(material, file);
+            }
+
+            *materialPtr = material;
+            return true;
+        });
+}
+
+
+//////////////////////////////////////////////////////////////////////////
+// Material cache
+
+bool Manager::setCacheDir(const std::string& dir)
+{
+    delete m_cache;
+    m_cache = nullptr;
+
+    if (dir.empty())
+        return true;
+
+    if (!io::Dir::exists((m_fs->root() + dir).c_str()))
+        return false;
+
+    m_cache = new MaterialCache(m_fs, dir);
+    return true;
+}
+
+std::string Manager::cacheDir() const
+{
+    return m_cache ? m_cache->dir() : std::string();
+}
+
+void Manager::_loadMaterial(Material* material, io::IFileReader* file)
+{
+    MCR_PROFILE_SCOPE("Manager::loadMaterial");
+
+    if (!m_cache)
     {
-        material = Material::create(this);
         _parseMaterial(material, file);
+        return;
     }
 
-    return material;
+    auto source = io::MemoryReader::fromFile(file);
+    auto key    = m_cache->key(source->data(), (std::size_t) source->size());
+
+    MaterialCache::Entry entry;
+
+    if (m_cache->load(key, entry) && _restoreMaterial(material, entry))
+        return;
+
+    entry = MaterialCache::Entry();
+    _parseMaterial(material, source, &entry);
+
+    if (m_batching)
+        m_cache->storeLater(key, entry, material);
+
+    else if (material->getProgramImage(entry.program))
+        m_cache->store(key, entry);
+}
+
+bool Manager::_restoreMaterial(Material* material, const MaterialCacheEntry& entry)
+{
+    // The material file is the same, but the shaders or what they include may not be
+    for (std::size_t i = 0; i < entry.shaders.size(); ++i)
+        if (_shaderHash(entry.shaders[i]) != entry.shaderHashes[i])
+            return false;
+
+    if (!material->setProgramImage(entry.program))
+        return false;
+
+    material->setRenderState(RenderState(entry.renderStateHash));
+    material->setPassHint(entry.passHint);
+
+    auto maxTextures = std::min<std::size_t>(material->numTextures(), entry.textures.size());
+
+    for (std::size_t i = 0; i < maxTextures; ++i)
+        material->setTexture(i, getTexture(entry.textures[i]));
+
+    return true;
+}
+
+rcptr<io::IFileReader> Manager::_openReader(const std::string& filename, bool binary)
+{
+    Name name(filename);
+
+    auto it = m_prefetched.find(name);
+    if (it != m_prefetched.end())
+    {
+        rcptr<io::IFileReader> file = it->second;
+        m_prefetched.erase(it);
+
+        return file;
+    }
+
+    if (m_missing.find(name) != m_missing.end())
+        return nullptr;
+
+    auto file = m_fs->openReader(filename.c_str(), binary);
+    if (!file)
+        m_missing[name] = true;
+
+    return file;
+}
+
+uint64 Manager::_shaderHash(const std::string& filename)
+{
+    // A shader already loaded is what the material would link against
+    auto shaderIt = m_shaders.find(filename);
+    if (shaderIt != m_shaders.end() && shaderIt->second)
+        return hashSources(shaderIt->second->sources());
+
+    auto file = m_fs->openReader(filename.c_str(), false);
+    if (!file)
+        return 0;
+
+    std::string source;
+    std::vector<std::string> sources;
+
+    file->readString0(source);
+
+    if (!m_preprocessor->preprocess(source.c_str(), sources))
+        sources.assign(1, source.c_str());
+
+    return hashSources(sources);
+}
+
+
+//////////////////////////////////////////////////////////////////////////
+// Batched compilation
+
+void Manager::beginBatch()
+{
+    if (GLEW_KHR_parallel_shader_compile)
+        glMaxShaderCompilerThreadsKHR(0xFFFFFFFF);
+
+    else if (GLEW_ARB_parallel_shader_compile)
+        glMaxShaderCompilerThreadsARB(0xFFFFFFFF);
+
+    m_batching = true;
+}
+
+void Manager::endBatch()
+{
+    MCR_PROFILE_SCOPE("Manager::endBatch");
+
+    if (!m_batching)
+        return;
+
+    m_batching = false;
+
+    // Take the shaders as they complete, which times them; without the
+    // extension, isReady() is always true and the timings add up instead
+    for (std::size_t numDone = 0; numDone < m_pendingShaders.size();)
+    {
+        auto progress = false;
+
+        for (auto it = m_pendingShaders.begin(); it != m_pendingShaders.end(); ++it)
+        {
+            if (!it->shader || !it->shader->isReady())
+                continue;
+
+            it->shader->isValid();
+            _addCompileTiming(it->filename, it->submitted);
+
+            it->shader = nullptr;
+            progress = true;
+            ++numDone;
+        }
+
+        if (!progress)
+            std::this_thread::yield();
+    }
+
+    // Likewise the links, each material set up as soon as its program is in
+    for (std::size_t numDone = 0; numDone < m_pendingLinks.size();)
+    {
+        auto progress = false;
+
+        for (auto it = m_pendingLinks.begin(); it != m_pendingLinks.end(); ++it)
+        {
+            if (!*it || !(*it)->isLinkReady())
+                continue;
+
+            (*it)->finishLink();
+
+            *it = nullptr;
+            progress = true;
+            ++numDone;
+        }
+
+        if (!progress)
+            std::this_thread::yield();
+    }
+
+    for (auto it = m_pendingTextures.begin(); it != m_pendingTextures.end(); ++it)
+    {
+        auto& material = *it->first;
+        auto& textures = it->second;
+
+        auto maxTextures = std::min<std::size_t>(material.numTextures(), textures.size());
+
+        for (std::size_t i = 0; i < maxTextures; ++i)
+            material.setTexture(i, getTexture(textures[i]));
+    }
+
+    if (m_cache)
+        m_cache->flush();
+
+    m_pendingShaders.clear();
+    m_pendingLinks.clear();
+    m_pendingTextures.clear();
+}
+
+void Manager::_addCompileTiming(const std::string& filename, int64 submitted)
+{
+    m_compileTimer.refresh();
+
+    CompileTiming timing = {filename, m_compileTimer.microseconds() - submitted};
+    m_compileTimings.push_back(timing);
+
+    g_log->debug("Shader %s compiled in %.2f ms", filename.c_str(), timing.microseconds / 1000.0);
 }
 
 
@@ -114,24 +441,24 @@ void Manager::clear()
     m_materials.clear();
     m_shaders.clear();
     m_tex.textures.clear();
+
+    m_prefetched.clear();
+    m_missing.clear();
 }
 
 void Manager::removeUnused()
 {
-    _dropAll(m_materials);
-    _dropAll(m_shaders);
-    _dropAll(m_tex.textures);
-
-    _grabAll(m_tex.textures);
-    _grabAll(m_shaders);
-    _grabAll(m_materials);
+    // Materials hold shaders and textures, so they go first
+    _removeUnused(m_materials);
+    _removeUnused(m_shaders);
+    _removeUnused(m_tex.textures);
 }
 
 
 //////////////////////////////////////////////////////////////////////////
 // Internals
 
-void Manager::_parseMaterial(Material* material, io::IReader* stream)
+void Manager::_parseMaterial(Material* material, io::IReader* stream, MaterialCacheEntry* entryOut)
 {
     static std::map<std::string, bool RenderState::*>   stateCommands;
     static std::map<std::string, DepthFn>               depthFnLiterals;
@@ -178,7 +505,7 @@ void Manager::_parseMaterial(Material* material, io::IReader* stream)
 
     RenderState renderState;
     ShaderList shaders;
-    std::vector<std::string> textures;
+    std::vector<std::string> shaderFiles, textures;
 
     char key[64] = {}, value[256] = {};
     int tokens = 0;
@@ -191,7 +518,7 @@ void Manager::_parseMaterial(Material* material, io::IReader* stream)
         switch (mode)
         {
         case States:
-            tokens = std::sscanf(parser.line().c_str(), "%63[^:] : %255s", key, value);
+            tokens = std::sscanf(parser.line(), "%63[^:] : %255s", key, value);
             if (tokens == 2)
             {
                 for (auto str = key; *str; ++str)
@@ -241,12 +568,15 @@ void Manager::_parseMaterial(Material* material, io::IReader* stream)
             break;
 
         case Shaders:
-            if (std::sscanf(parser.line().c_str(), " - %255s", value) == 1)
+            if (std::sscanf(parser.line(), " - %255s", value) == 1)
+            {
                 shaders.add(getShader(value));
+                shaderFiles.push_back(value);
+            }
             break;
 
         case Textures:
-            if (std::sscanf(parser.line().c_str(), " - %255s", value) == 1)
+            if (std::sscanf(parser.line(), " - %255s", value) == 1)
                 textures.push_back(value);
             break;
         }
@@ -255,10 +585,27 @@ void Manager::_parseMaterial(Material* material, io::IReader* stream)
     material->setRenderState(renderState);
     material->setShaders(shaders);
 
-    auto maxTextures = std::min<std::size_t>(material->numTextures(), textures.size());
+    // Texture slots are known once the program is, in endBatch() when batching
+    if (m_batching)
+        m_pendingTextures.push_back(std::make_pair(material, textures));
+    else
+    {
+        auto maxTextures = std::min<std::size_t>(material->numTextures(), textures.size());
 
-    for (std::size_t i = 0; i < maxTextures; ++i)
-        material->setTexture(i, getTexture(textures[i]));
+        for (std::size_t i = 0; i < maxTextures; ++i)
+            material->setTexture(i, getTexture(textures[i]));
+    }
+
+    if (entryOut)
+    {
+        entryOut->renderStateHash = renderState.hash();
+        entryOut->passHint        = material->passHint();
+        entryOut->textures        = textures;
+        entryOut->shaders         = shaderFiles;
+
+        for (auto it = shaderFiles.begin(); it != shaderFiles.end(); ++it)
+            entryOut->shaderHashes.push_back(_shaderHash(*it));
+    }
 }
 
 } // ns mtl
@@ -2,6 +2,7 @@
 #include <mcr/gfx/mtl/Material.h>
 
 #include <mcr/Log.h>
+#include <mcr/Profiler.h>
 #include <mcr/gfx/mtl/Manager.h>
 #include "mcr/gfx/GLState.h"
 #include "ParamUploadFn.h"
@@ -16,6 +17,7 @@ namespace mtl {
 Material::Material(Manager* mgr):
     m_mgr(mgr),
     m_passHint(0),
+    m_linkPending(false),
     m_program()
 {
     m_renderStateHash = m_renderState.hash();
@@ -33,21 +35,55 @@ Material::~Material()
 
 bool Material::_link()
 {
-    using namespace mtl;
-
-    m_paramDefs.clear();
-    m_buffers.clear();
-    m_textures.clear();
-
-    if (m_program)
-        glDeleteProgram(m_program);
-
-    m_program = glCreateProgram();
+    _resetProgram();
 
     for (auto shaderIt = m_shaders.shaders.begin(); shaderIt != m_shaders.shaders.end(); ++shaderIt)
         glAttachShader(m_program, (*shaderIt)->handle());
 
+    if (GLEW_ARB_get_program_binary)
+        glProgramParameteri(m_program, GL_PROGRAM_BINARY_RETRIEVABLE_HINT, GL_TRUE);
+
     glLinkProgram(m_program);
+    m_linkPending = true;
+
+    // Status and reflection would wait for the compiles and the link
+    if (m_mgr->isBatching())
+    {
+        m_mgr->deferLink(this);
+        return true;
+    }
+
+    return finishLink();
+}
+
+bool Material::isLinkReady() const
+{
+    if (!m_linkPending || (!GLEW_KHR_parallel_shader_compile && !GLEW_ARB_parallel_shader_compile))
+        return true;
+
+    GLint done;
+    glGetProgramiv(m_program, GL_COMPLETION_STATUS_KHR, &done);
+
+    return done == GL_TRUE;
+}
+
+bool Material::finishLink()
+{
+    if (!m_linkPending)
+    {
+        GLint status = GL_FALSE;
+
+        if (m_program)
+            glGetProgramiv(m_program, GL_LINK_STATUS, &status);
+
+        return status == GL_TRUE;
+    }
+
+    m_linkPending = false;
+
+    // Compile errors first, they explain the link failure
+    for (auto shaderIt = m_shaders.shaders.begin(); shaderIt != m_shaders.shaders.end(); ++shaderIt)
+        (*shaderIt)->isValid();
 
     GLint status;
     glGetProgramiv(m_program, GL_LINK_STATUS, &status);
@@ -64,9 +100,30 @@ bool Material::_link()
         return false;
     }
 
-    if (!GLEW_EXT_direct_state_access)
-        g_glState->setActiveProgram(m_program);
+    ProgramImage image;
+
+    _reflect(image);
+    _setup(image);
+
+    return true;
+}
+
+void Material::_resetProgram()
+{
+    m_linkPending = false;
 
+    m_paramDefs.clear();
+    m_buffers.clear();
+    m_textures.clear();
+
+    if (m_program)
+        glDeleteProgram(m_program);
+
+    m_program = glCreateProgram();
+}
+
+void Material::_reflect(ProgramImage& image) const
+{
     GLint numUniforms;
     glGetProgramiv(m_program, GL_ACTIVE_UNIFORMS, &numUniforms);
 
@@ -77,8 +134,6 @@ bool Material::_link()
 
         std::string name(longestUniName, '\0');
 
-        ParamLayout layout;
-
         for (int i = 0; i < numUniforms; ++i)
         {
             GLsizei length;
@@ -89,8 +144,54 @@ bool Material::_link()
             int loc = glGetUniformLocation(m_program, name.c_str());
             if (loc == -1)
                 continue;
-            
-            switch (type)
+
+            ProgramImage::Uniform uniform = {name.c_str(), type, loc};
+            image.uniforms.push_back(uniform);
+        }
+    }
+
+    GLint numUniformBlocks;
+    glGetProgramiv(m_program, GL_ACTIVE_UNIFORM_BLOCKS, &numUniformBlocks);
+
+    if (numUniformBlocks)
+    {
+        GLint longestBlockName = 0;
+        glGetProgramiv(m_program, GL_ACTIVE_UNIFORM_BLOCK_MAX_NAME_LENGTH, &longestBlockName); // doesn't work with Intel HD Graphics (I)
+
+        if (!longestBlockName)
+            longestBlockName = 128;
+
+        std::string name(longestBlockName, '\0');
+
+        for (int i = 0; i < numUniformBlocks; ++i)
+        {
+            GLint length;
+            glGetActiveUniformBlockName(m_program, i, longestBlockName, &length, &name[0]);
+
+            if (length >= 6 && name.compare(std::size_t(length - 6), 6, "Layout") == 0)
+                length -= 6;
+
+            ProgramImage::Block block = {name.substr(0, std::size_t(length)), (uint) i};
+            image.blocks.push_back(block);
+        }
+    }
+}
+
+void Material::_setup(const ProgramImage& image)
+{
+    if (!GLEW_EXT_direct_state_access)
+        g_glState->setActiveProgram(m_program);
+
+    if (!image.uniforms.empty())
+    {
+        ParamLayout layout;
+
+        for (auto it = image.uniforms.begin(); it != image.uniforms.end(); ++it)
+        {
+            auto name = it->name.c_str();
+            auto loc  = it->location;
+
+            switch (it->type)
             {
             case GL_SAMPLER_2D:
             case GL_SAMPLER_2D_ARRAY:
@@ -113,26 +214,26 @@ bool Material::_link()
                 continue;
             }
 
-            switch (type)
+            switch (it->type)
             {
-            case GL_FLOAT:             layout.addFloat(name.c_str());  break;
-            case GL_FLOAT_VEC2:        layout.addVec2(name.c_str());   break;
-            case GL_FLOAT_VEC3:        layout.addVec3(name.c_str());   break;
-            case GL_FLOAT_VEC4:        layout.addVec4(name.c_str());   break;
-            case GL_FLOAT_MAT4:        layout.addMat4(name.c_str());   break;
-            case GL_DOUBLE:            layout.addDouble(name.c_str()); break;
-            case GL_DOUBLE_VEC2:       layout.addDVec2(name.c_str());  break;
-            case GL_DOUBLE_VEC3:       layout.addDVec3(name.c_str());  break;
-            case GL_DOUBLE_VEC4:       layout.addDVec4(name.c_str());  break;
-            case GL_DOUBLE_MAT4:       layout.addDMat4(name.c_str());  break;
-            case GL_INT:               layout.addInt(name.c_str());    break;
-            case GL_INT_VEC2:          layout.addIVec2(name.c_str());  break;
-            case GL_INT_VEC3:          layout.addIVec3(name.c_str());  break;
-            case GL_INT_VEC4:          layout.addIVec4(name.c_str());  break;
-            case GL_UNSIGNED_INT:      layout.addUInt(name.c_str());   break;
-            case GL_UNSIGNED_INT_VEC2: layout.addUVec2(name.c_str());  break;
-            case GL_UNSIGNED_INT_VEC3: layout.addUVec3(name.c_str());  break;
-            case GL_UNSIGNED_INT_VEC4: layout.addUVec4(name.c_str());  break;
+            case GL_FLOAT:             layout.addFloat(name);  break;
+            case GL_FLOAT_VEC2:        layout.addVec2(name);   break;
+            case GL_FLOAT_VEC3:        layout.addVec3(name);   break;
+            case GL_FLOAT_VEC4:        layout.addVec4(name);   break;
+            case GL_FLOAT_MAT4:        layout.addMat4(name);   break;
+            case GL_DOUBLE:            layout.addDouble(name); break;
+            case GL_DOUBLE_VEC2:       layout.addDVec2(name);  break;
+            case GL_DOUBLE_VEC3:       layout.addDVec3(name);  break;
+            case GL_DOUBLE_VEC4:       layout.addDVec4(name);  break;
+            case GL_DOUBLE_MAT4:       layout.addDMat4(name);  break;
+            case GL_INT:               layout.addInt(name);    break;
+            case GL_INT_VEC2:          layout.addIVec2(name);  break;
+            case GL_INT_VEC3:          layout.addIVec3(name);  break;
+            case GL_INT_VEC4:          layout.addIVec4(name);  break;
+            case GL_UNSIGNED_INT:      layout.addUInt(name);   break;
+            case GL_UNSIGNED_INT_VEC2: layout.addUVec2(name);  break;
+            case GL_UNSIGNED_INT_VEC3: layout.addUVec3(name);  break;
+            case GL_UNSIGNED_INT_VEC4: layout.addUVec4(name);  break;
             default: continue;
             }
 
@@ -141,39 +242,69 @@ bool Material::_link()
         }
 
         setLayout(layout, false);
-    } // if (numUniforms)
-
-    GLint numUniformBlocks;
-    glGetProgramiv(m_program, GL_ACTIVE_UNIFORM_BLOCKS, &numUniformBlocks);
+    }
 
-    if (numUniformBlocks)
+    for (auto it = image.blocks.begin(); it != image.blocks.end(); ++it)
     {
-        GLint longestBlockName = 0;
-        glGetProgramiv(m_program, GL_ACTIVE_UNIFORM_BLOCK_MAX_NAME_LENGTH, &longestBlockName); // doesn't work with Intel HD Graphics (I)
+        if (auto buffer = m_mgr->paramBuffer(it->name))
+        {
+            auto binding = m_mgr->requestParamBufferBinding();
 
-        if (!longestBlockName)
-            longestBlockName = 128;
+            glUniformBlockBinding(m_program, it->index, binding);
+            m_buffers.push_back(std::make_pair(binding, buffer));
+        }
+    }
+}
 
-        std::string name(longestBlockName, '\0');
 
-        for (int i = 0; i < numUniformBlocks; ++i)
-        {
-            GLint length;
-            glGetActiveUniformBlockName(m_program, i, longestBlockName, &length, &name[0]);
+//////////////////////////////////////////////////////////////////////////
+// Program binaries
 
-            if (length >= 6 && name.compare(std::size_t(length - 6), 6, "Layout") == 0)
-                name[std::size_t(length - 6)] = '\0';
+bool Material::getProgramImage(ProgramImage& imageOut) const
+{
+    if (!m_program || m_linkPending || !GLEW_ARB_get_program_binary)
+        return false;
 
-            if (auto buffer = m_mgr->paramBuffer(name.c_str()))
-            {
-                auto binding = m_mgr->requestParamBufferBinding();
+    GLint length = 0;
+    glGetProgramiv(m_program, GL_PROGRAM_BINARY_LENGTH, &length);
 
-                glUniformBlockBinding(m_program, (uint) i, binding);
-                m_buffers.push_back(std::make_pair(binding, buffer));
-            }
-        }
+    if (length <= 0)
+        return false;
+
+    GLenum format;
+    imageOut.binary.resize((std::size_t) length);
+    glGetProgramBinary(m_program, length, nullptr, &format, &imageOut.binary[0]);
+
+    imageOut.format = format;
+    imageOut.uniforms.clear();
+    imageOut.blocks.clear();
+
+    _reflect(imageOut);
+    return true;
+}
+
+bool Material::setProgramImage(const ProgramImage& image)
+{
+    if (!GLEW_ARB_get_program_binary || image.binary.empty())
+        return false;
+
+    _resetProgram();
+    glProgramBinary(m_program, image.format, &image.binary[0], (GLsizei) image.binary.size());
+
+    GLint status;
+    glGetProgramiv(m_program, GL_LINK_STATUS, &status);
+
+    if (!status)
+    {
+        glDeleteProgram(m_program);
+        m_program = 0;
+
+        return false;
     }
 
+    m_shaders = ShaderList();
+    _setup(image);
+
     return true;
 }
 
@@ -183,6 +314,8 @@ bool Material::_link()
 
 void Material::syncParams()
 {
+    MCR_PROFILE_SCOPE("Material::syncParams");
+
     g_glState->setActiveProgram(m_program);
 
     for (std::size_t i = 0; i < m_paramDefs.size(); ++i)
@@ -196,12 +329,18 @@ void Material::syncParams()
 
         uploadFnTable[layout().params[i].first](m_program, pdef.location, pdef.dirtyData);
         pdef.dirtyData = nullptr;
+
+        ++g_glState->stats().numUniforms;
     }
 
     for (std::size_t i = 0; i < m_buffers.size(); ++i)
     {
-        m_buffers[i].second->sync();
-        g_glState->bindBufferBase(GL_UNIFORM_BUFFER, m_buffers[i].first, m_buffers[i].second->handle());
+        ParamBuffer* buffer = m_buffers[i].second;
+
+        buffer->sync();
+
+        if (buffer->size())
+            g_glState->bindBufferRange(GL_UNIFORM_BUFFER, m_buffers[i].first, buffer->handle(), buffer->offset(), buffer->size());
     }
 
     for (std::size_t i = 0; i < m_textures.size(); ++i)
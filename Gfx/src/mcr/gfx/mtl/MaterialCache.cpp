@@ -0,0 +1,231 @@
+#include "Universe.h"
+#include "MaterialCache.h"
+
+#include <cstdio>
+#include "mcr/gfx/GLState.h"
+
+namespace mcr {
+namespace gfx {
+namespace mtl {
+
+namespace {
+
+const uint g_magic   = 0x4d43524d; // MCRM
+const uint g_version = 1;
+
+// Anything larger in a cache file means it's corrupt
+const uint g_maxCount = 1u << 16;
+const uint g_maxBinary = 1u << 26;
+
+void writeString(io::IWriter* file, const std::string& str)
+{
+    file->write((uint) str.size());
+    file->write(str.data(), str.size());
+}
+
+bool readString(io::IReader* file, std::string& str)
+{
+    uint size;
+    if (!file->read(size) || size > g_maxCount)
+        return false;
+
+    str.resize(size);
+    return !size || file->read(&str[0], size) == size;
+}
+
+bool readCount(io::IReader* file, uint& count)
+{
+    return file->read(count) && count <= g_maxCount;
+}
+
+} // ns
+
+
+MaterialCache::MaterialCache(io::FileSystem* fs, const std::string& dir):
+    m_fs(fs),
+    m_dir(dir)
+{
+    if (!m_dir.empty() && m_dir.back() != '/')
+        m_dir += '/';
+
+    // Program binaries are only valid for the driver that made them
+    auto& vendor   = g_glState->vendor();
+    auto& renderer = g_glState->renderer();
+    auto  version  = reinterpret_cast<const char*>(glGetString(GL_VERSION));
+
+    m_driverHash = hash(vendor.data(), vendor.size());
+    m_driverHash = hash(renderer.data(), renderer.size(), m_driverHash);
+
+    if (version)
+        m_driverHash = hash(version, std::strlen(version), m_driverHash);
+}
+
+uint64 MaterialCache::key(const void* source, std::size_t size) const
+{
+    return hash(source, size, m_driverHash);
+}
+
+uint64 MaterialCache::hash(const void* data, std::size_t size, uint64 seed)
+{
+    auto bytes = static_cast<const byte*>(data);
+
+    for (std::size_t i = 0; i < size; ++i)
+        seed = (seed ^ bytes[i]) * 1099511628211ull;
+
+    return seed;
+}
+
+
+//////////////////////////////////////////////////////////////////////////
+// Entry I/O
+
+bool MaterialCache::load(uint64 key, Entry& entryOut) const
+{
+    auto file = m_fs->openReader(_path(key).c_str());
+    if (!file)
+        return false;
+
+    uint magic, version, count;
+    uint64 storedKey;
+
+    if (!file->read(magic) || magic != g_magic || !file->read(version) || version != g_version)
+        return false;
+
+    if (!file->read(storedKey) || storedKey != key)
+        return false;
+
+    if (!file->read(entryOut.renderStateHash) || !file->read(entryOut.passHint))
+        return false;
+
+    if (!readCount(file, count))
+        return false;
+
+    entryOut.textures.resize(count);
+
+    for (uint i = 0; i < count; ++i)
+        if (!readString(file, entryOut.textures[i]))
+            return false;
+
+    if (!readCount(file, count))
+        return false;
+
+    entryOut.shaders.resize(count);
+    entryOut.shaderHashes.resize(count);
+
+    for (uint i = 0; i < count; ++i)
+        if (!readString(file, entryOut.shaders[i]) || !file->read(entryOut.shaderHashes[i]))
+            return false;
+
+    auto& program = entryOut.program;
+
+    if (!file->read(program.format) || !file->read(count) || count > g_maxBinary)
+        return false;
+
+    program.binary.resize(count);
+
+    if (count && file->read(&program.binary[0], count) != count)
+        return false;
+
+    if (!readCount(file, count))
+        return false;
+
+    program.uniforms.resize(count);
+
+    for (uint i = 0; i < count; ++i)
+    {
+        auto& uniform = program.uniforms[i];
+
+        if (!readString(file, uniform.name) || !file->read(uniform.type) || !file->read(uniform.location))
+            return false;
+    }
+
+    if (!readCount(file, count))
+        return false;
+
+    program.blocks.resize(count);
+
+    for (uint i = 0; i < count; ++i)
+        if (!readString(file, program.blocks[i].name) || !file->read(program.blocks[i].index))
+            return false;
+
+    return true;
+}
+
+bool MaterialCache::store(uint64 key, const Entry& entry) const
+{
+    auto file = m_fs->openWriter(_path(key).c_str());
+    if (!file)
+        return false;
+
+    file->write(g_magic);
+    file->write(g_version);
+    file->write(key);
+
+    file->write(entry.renderStateHash);
+    file->write(entry.passHint);
+
+    file->write((uint) entry.textures.size());
+
+    for (auto it = entry.textures.begin(); it != entry.textures.end(); ++it)
+        writeString(file, *it);
+
+    file->write((uint) entry.shaders.size());
+
+    for (std::size_t i = 0; i < entry.shaders.size(); ++i)
+    {
+        writeString(file, entry.shaders[i]);
+        file->write(entry.shaderHashes[i]);
+    }
+
+    auto& program = entry.program;
+
+    file->write(program.format);
+    file->write((uint) program.binary.size());
+    file->write(program.binary.data(), program.binary.size());
+
+    file->write((uint) program.uniforms.size());
+
+    for (auto it = program.uniforms.begin(); it != program.uniforms.end(); ++it)
+    {
+        writeString(file, it->name);
+        file->write(it->type);
+        file->write(it->location);
+    }
+
+    file->write((uint) program.blocks.size());
+
+    for (auto it = program.blocks.begin(); it != program.blocks.end(); ++it)
+    {
+        writeString(file, it->name);
+        file->write(it->index);
+    }
+
+    return true;
+}
+
+void MaterialCache::storeLater(uint64 key, const Entry& entry, Material* material)
+{
+    Pending pending = {key, entry, material};
+    m_pending.push_back(pending);
+}
+
+void MaterialCache::flush()
+{
+    for (auto it = m_pending.begin(); it != m_pending.end(); ++it)
+        if (it->material->getProgramImage(it->entry.program))
+            store(it->key, it->entry);
+
+    m_pending.clear();
+}
+
+std::string MaterialCache::_path(uint64 key) const
+{
+    char name[24];
+    std::snprintf(name, sizeof(name), "%016llx.mtlc", (unsigned long long) key);
+
+    return m_dir + name;
+}
+
+} // ns mtl
+} // ns gfx
+} // ns mcr
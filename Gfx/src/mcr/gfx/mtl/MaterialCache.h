@@ -0,0 +1,68 @@
+// Internal header
+#pragma once
+
+#include <string>
+#include <vector>
+#include <mcr/GfxExtern.h>
+#include <mcr/io/FileSystem.h>
+#include <mcr/gfx/mtl/Material.h>
+
+namespace mcr {
+namespace gfx {
+namespace mtl {
+
+struct MaterialCacheEntry
+{
+    uint                        renderStateHash;
+    int                         passHint;
+    std::vector<std::string>    textures;
+    std::vector<std::string>    shaders;
+    std::vector<uint64>         shaderHashes; // of the preprocessed sources
+    ProgramImage                program;
+
+    MaterialCacheEntry(): renderStateHash(0), passHint(0) {}
+};
+
+//! Parsed materials with their linked programs, one file per material in
+//! a cache directory. Entries are keyed by the material source and the GL
+//! driver; the shader sources are checked by the manager on load.
+class MaterialCache
+{
+public:
+    typedef MaterialCacheEntry Entry;
+
+    MCR_GFX_INTERN MaterialCache(io::FileSystem* fs, const std::string& dir);
+
+    const std::string& dir() const { return m_dir; }
+
+    MCR_GFX_INTERN uint64 key(const void* source, std::size_t size) const;
+
+    MCR_GFX_INTERN bool load(uint64 key, Entry& entryOut) const;
+    MCR_GFX_INTERN bool store(uint64 key, const Entry& entry) const;
+
+    //! Store once \c material has finished linking, on flush()
+    MCR_GFX_INTERN void storeLater(uint64 key, const Entry& entry, Material* material);
+    MCR_GFX_INTERN void flush();
+
+    //! FNV-1a, chained through \c seed
+    MCR_GFX_INTERN static uint64 hash(const void* data, std::size_t size, uint64 seed = 14695981039346656037ull);
+
+private:
+    std::string _path(uint64 key) const;
+
+    struct Pending
+    {
+        uint64          key;
+        Entry           entry;
+        rcptr<Material> material;
+    };
+
+    io::FileSystem*         m_fs;
+    std::string             m_dir;
+    uint64                  m_driverHash;
+    std::vector<Pending>    m_pending;
+};
+
+} // ns mtl
+} // ns gfx
+} // ns mcr
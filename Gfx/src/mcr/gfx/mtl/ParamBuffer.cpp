@@ -1,6 +1,7 @@
 #include "Universe.h"
 #include <mcr/gfx/mtl/ParamBuffer.h>
 
+#include <mcr/gfx/geom/mem/StreamMemory.h>
 #include "mcr/gfx/GLState.h"
 
 namespace mcr {
@@ -15,6 +16,12 @@ static const GLenum g_bufferDrawUsageTable[] =
     GL_STATIC_DRAW, GL_DYNAMIC_DRAW, GL_STREAM_DRAW
 };
 
+static geom::mem::StreamMemory& streamMemory()
+{
+    static geom::mem::StreamMemory memory(geom::mem::StreamMemory::Uniform);
+    return memory;
+}
+
 
 //////////////////////////////////////////////////////////////////////////
 // Structors
@@ -41,6 +48,23 @@ void ParamBuffer::sync()
     if (!m_dirty || !m_handle || !numParams())
         return;
 
+    g_glState->stats().paramBytes += data().size();
+
+    // Anything updated more often than once in a while goes through stream
+    // memory, which doesn't make the driver reallocate or wait on the GPU
+    if (m_usage != Static)
+    {
+        if (!m_stream)
+            m_stream = streamMemory().allocate(data().size());
+
+        m_stream->write(0, data().size(), &data()[0]);
+        m_dirty = false;
+
+        return;
+    }
+
+    m_stream = nullptr;
+
     if (GLEW_EXT_direct_state_access)
         glNamedBufferDataEXT(m_handle, data().size(), &data()[0], g_bufferDrawUsageTable[m_usage]);
     else
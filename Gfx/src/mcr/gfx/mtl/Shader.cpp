@@ -24,6 +24,7 @@ Shader::Shader(Type type):
     m_type(type),
     m_htype(g_shaderTypeTable[type]),
     m_preprocessor(),
+    m_pending(false),
     m_valid(false)
 {
     m_handle = glCreateShader(m_htype);
@@ -42,15 +43,38 @@ bool Shader::compile()
 {
     glCompileShader(m_handle);
 
-    GLint status;
-    glGetShaderiv(m_handle, GL_COMPILE_STATUS, &status);
+    m_pending = true;
+    m_valid   = false;
 
-    m_valid = status == GL_TRUE;
+    return true;
+}
 
-    if (!m_valid)
-        g_log->error("Shader compilation failed: %s", log().c_str());
+bool Shader::isReady() const
+{
+    if (!m_pending || (!GLEW_KHR_parallel_shader_compile && !GLEW_ARB_parallel_shader_compile))
+        return true;
 
-    return true;
+    GLint done;
+    glGetShaderiv(m_handle, GL_COMPLETION_STATUS_KHR, &done);
+
+    return done == GL_TRUE;
+}
+
+bool Shader::isValid() const
+{
+    if (m_pending)
+    {
+        GLint status;
+        glGetShaderiv(m_handle, GL_COMPILE_STATUS, &status);
+
+        m_valid   = status == GL_TRUE;
+        m_pending = false;
+
+        if (!m_valid)
+            g_log->error("Shader compilation failed: %s", log().c_str());
+    }
+
+    return m_valid;
 }
 
 std::string Shader::log() const
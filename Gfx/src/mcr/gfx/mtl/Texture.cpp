@@ -43,41 +43,49 @@ bool Texture::load(io::IReader* stream)
 
     auto success = stream->read(buffer, header.size) == header.size;
     if (success)
-    {
-        m_size.set(header.width, header.height);
-
-        switch (header.fmt)
-        {
-        case GL_COMPRESSED_RGBA:
-        case GL_COMPRESSED_RGBA_S3TC_DXT1_EXT:
-        case GL_COMPRESSED_RGBA_S3TC_DXT3_EXT:
-        case GL_COMPRESSED_RGBA_S3TC_DXT5_EXT:
-            m_hasAlpha = true;
-            break;
-        default:
-            m_hasAlpha = false;
-        }
-
-        g_glState->bindTexture(m_handle);
-
-        glCompressedTexImage2D(GL_TEXTURE_2D, 0,
-            header.fmt,
-            header.width, header.height, 0,
-            header.size, buffer);
-
-        /*glTexImage2D(GL_TEXTURE_2D, 0,
-            m_hasAlpha ? GL_COMPRESSED_RGBA : GL_COMPRESSED_RGB,
-            m_size.x(), m_size.y(), 0, hasAlpha ? GL_RGBA : GL_RGB,
-            GL_UNSIGNED_BYTE, buffer);*/
-
-        glGenerateMipmap(GL_TEXTURE_2D);
-    }
+        _upload(header.fmt, header.width, header.height, header.size, buffer);
 
     delete [] buffer;
 
     return success;
 }
 
+bool Texture::load(io::IFileReader* stream)
+{
+    if (!stream || !stream->data())
+        return load(static_cast<io::IReader*>(stream));
+
+    TexHeaderTMP header;
+    if (stream->read(header) != sizeof(header))
+        return false;
+
+    auto pos = stream->tell();
+    if (pos + header.size > stream->size())
+        return false;
+
+    _upload(header.fmt, header.width, header.height, header.size,
+            static_cast<const byte*>(stream->data()) + pos);
+
+    stream->seek(pos + header.size);
+
+    return true;
+}
+
+bool Texture::check(io::IFileReader* stream)
+{
+    if (!stream)
+        return false;
+
+    auto pos = stream->tell();
+
+    TexHeaderTMP header;
+    auto read = stream->read(header);
+
+    stream->seek(pos);
+
+    return read == sizeof(header) && pos + sizeof(header) + header.size <= stream->size();
+}
+
 bool Texture::save(io::IWriter* writer) const
 {
     if (!writer)
@@ -110,6 +118,37 @@ bool Texture::save(io::IWriter* writer) const
     return written == sizeof(header) + (std::size_t) bufSize;
 }
 
+void Texture::_upload(uint fmt, int width, int height, uint size, const void* data)
+{
+    m_size.set(width, height);
+
+    switch (fmt)
+    {
+    case GL_COMPRESSED_RGBA:
+    case GL_COMPRESSED_RGBA_S3TC_DXT1_EXT:
+    case GL_COMPRESSED_RGBA_S3TC_DXT3_EXT:
+    case GL_COMPRESSED_RGBA_S3TC_DXT5_EXT:
+        m_hasAlpha = true;
+        break;
+    default:
+        m_hasAlpha = false;
+    }
+
+    g_glState->bindTexture(m_handle);
+
+    glCompressedTexImage2D(GL_TEXTURE_2D, 0,
+        fmt,
+        width, height, 0,
+        size, data);
+
+    /*glTexImage2D(GL_TEXTURE_2D, 0,
+        m_hasAlpha ? GL_COMPRESSED_RGBA : GL_COMPRESSED_RGB,
+        m_size.x(), m_size.y(), 0, hasAlpha ? GL_RGBA : GL_RGB,
+        GL_UNSIGNED_BYTE, buffer);*/
+
+    glGenerateMipmap(GL_TEXTURE_2D);
+}
+
 } // ns mtl
 } // ns gfx
 } // ns mcr
@@ -1,11 +1,22 @@
 #include <GLFW/glfw3.h>
 
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <vector>
+
 #include <mcr/Config.h>
 #include <mcr/Timer.h>
 #include <mcr/Log.h>
+#include <mcr/Profiler.h>
+#include <mcr/io/LineParser.h>
 
+#include <mcr/gfx/AsyncLoader.h>
 #include <mcr/gfx/Camera.h>
+#include <mcr/gfx/HeadlessContext.h>
 #include <mcr/gfx/Renderer.h>
+#include <mcr/gfx/RenderQueue.h>
 #include <mcr/gfx/mtl/Manager.h>
 #include <mcr/gfx/geom/MeshManager.h>
 #include <mcr/gfx/geom/mem/NaiveMemory.h>
@@ -14,6 +25,200 @@ using namespace mcr;
 using namespace gfx;
 
 GLFWwindow* win;
+gfx::HeadlessContext headless;
+
+struct Options
+{
+    const char* benchmarkPath;  // camera path to replay, interactive if none
+    const char* outputFile;     // benchmark results, stdout if none
+    const char* profileFile;    // Chrome trace of the run, none if not profiling
+    int         numFrames;
+    bool        headless;
+    ivec2       size;
+
+    Options(): benchmarkPath(), outputFile(), profileFile(), numFrames(2000), headless(), size(1024, 768) {}
+};
+
+
+//////////////////////////////////////////////////////////////////////////
+// Benchmark
+
+//! Write \c str as the inside of a JSON string
+void printEscaped(FILE* out, const char* str)
+{
+    for (; *str; ++str)
+    {
+        if (*str == '"' || *str == '\\')
+            std::fputc('\\', out);
+
+        std::fputc(*str, out);
+    }
+}
+
+//! Keyframes read from "time  x y z  pitch yaw roll" lines, # comments a
+//! line out; in between, position and rotation are interpolated linearly
+class CameraPath
+{
+public:
+    bool load(io::IReader* stream)
+    {
+        m_keys.clear();
+
+        if (!stream)
+            return false;
+
+        io::LineParser parser(stream);
+
+        while (parser.readLine())
+        {
+            if (parser.line()[0] == '#')
+                continue;
+
+            Key key;
+            vec3& p = key.pos;
+            vec3& r = key.rot;
+
+            if (std::sscanf(parser.line(), "%lf %f %f %f %f %f %f", &key.time,
+                            &p[0], &p[1], &p[2], &r[0], &r[1], &r[2]) != 7)
+            {
+                g_log->error("Bad camera path key: '%s'", parser.line());
+                return false;
+            }
+
+            if (!m_keys.empty() && key.time <= m_keys.back().time)
+            {
+                g_log->error("Camera path keys must be in order of time");
+                return false;
+            }
+
+            m_keys.push_back(key);
+        }
+
+        return !m_keys.empty();
+    }
+
+    //! Loops around after the last key
+    void sample(double time, vec3& posOut, vec3& rotOut) const
+    {
+        auto duration = m_keys.back().time;
+
+        if (duration > 0)
+            time -= duration * (int64) (time / duration);
+
+        auto next = std::upper_bound(m_keys.begin(), m_keys.end(), time,
+            [] (double t, const Key& key) { return t < key.time; });
+
+        if (next == m_keys.begin() || next == m_keys.end())
+        {
+            auto& key = next == m_keys.end() ? m_keys.back() : m_keys.front();
+
+            posOut = key.pos;
+            rotOut = key.rot;
+            return;
+        }
+
+        auto& a = next[-1];
+        auto& b = next[0];
+        auto  t = (float) ((time - a.time) / (b.time - a.time));
+
+        posOut = a.pos + (b.pos - a.pos) * t;
+        rotOut = a.rot + (b.rot - a.rot) * t;
+    }
+
+private:
+    struct Key
+    {
+        double  time;
+        vec3    pos, rot;
+    };
+
+    std::vector<Key> m_keys;
+};
+
+//! Min, mean, percentiles and max of a series of timings, in milliseconds
+struct TimingStats
+{
+    double min, mean, p50, p95, p99, max;
+
+    explicit TimingStats(std::vector<double> ms)
+    {
+        std::sort(ms.begin(), ms.end());
+
+        double sum = 0;
+        for (auto it = ms.begin(); it != ms.end(); ++it)
+            sum += *it;
+
+        min  = ms.front();
+        max  = ms.back();
+        mean = sum / ms.size();
+        p50  = percentile(ms, 50);
+        p95  = percentile(ms, 95);
+        p99  = percentile(ms, 99);
+    }
+
+    // Nearest rank
+    static double percentile(const std::vector<double>& sorted, int p)
+    {
+        auto rank = (sorted.size() * p + 99) / 100;
+        return sorted[rank ? rank - 1 : 0];
+    }
+
+    void print(FILE* out, const char* name) const
+    {
+        std::fprintf(out,
+            "  \"%s\": {\"min\": %.4f, \"mean\": %.4f, \"p50\": %.4f, "
+            "\"p95\": %.4f, \"p99\": %.4f, \"max\": %.4f}",
+            name, min, mean, p50, p95, p99, max);
+    }
+};
+
+//! Renderer stats summed over frames, printed as means per frame
+struct RenderTotals
+{
+    RenderStats sum;
+    int         numFrames;
+
+    RenderTotals(): sum(), numFrames(0) {}
+
+    void add(const RenderStats& frame)
+    {
+        sum.numDraws              += frame.numDraws;
+        sum.numTriangles          += frame.numTriangles;
+        sum.issued.programs       += frame.issued.programs;
+        sum.issued.textures       += frame.issued.textures;
+        sum.issued.buffers        += frame.issued.buffers;
+        sum.issued.vertexArrays   += frame.issued.vertexArrays;
+        sum.skipped.programs      += frame.skipped.programs;
+        sum.skipped.textures      += frame.skipped.textures;
+        sum.skipped.buffers       += frame.skipped.buffers;
+        sum.skipped.vertexArrays  += frame.skipped.vertexArrays;
+        sum.renderStateChanges    += frame.renderStateChanges;
+        sum.numUniforms           += frame.numUniforms;
+        sum.paramBytes            += frame.paramBytes;
+        sum.bufferBytes           += frame.bufferBytes;
+
+        ++numFrames;
+    }
+
+    void print(FILE* out, const char* name) const
+    {
+        double n = numFrames ? numFrames : 1;
+
+        std::fprintf(out,
+            "  \"%s\": {\"draws\": %.1f, \"triangles\": %.1f, "
+            "\"programs\": [%.1f, %.1f], \"textures\": [%.1f, %.1f], "
+            "\"buffers\": [%.1f, %.1f], \"vertex_arrays\": [%.1f, %.1f], "
+            "\"render_state_changes\": %.1f, \"uniforms\": %.1f, "
+            "\"param_bytes\": %.1f, \"buffer_bytes\": %.1f}",
+            name, sum.numDraws / n, sum.numTriangles / n,
+            sum.issued.programs / n,     sum.skipped.programs / n,
+            sum.issued.textures / n,     sum.skipped.textures / n,
+            sum.issued.buffers / n,      sum.skipped.buffers / n,
+            sum.issued.vertexArrays / n, sum.skipped.vertexArrays / n,
+            sum.renderStateChanges / n, sum.numUniforms / n,
+            sum.paramBytes / n, sum.bufferBytes / n);
+    }
+};
 
 //////////////////////////////////////////////////////////////////////////
 // Scene
@@ -45,10 +250,8 @@ struct Scene
     meshes;
 
 
-    void load(mtl::Manager& mtlm, geom::MeshManager& meshm)
+    void load(mtl::Manager& mtlm, geom::MeshManager& meshm, AsyncLoader& loader)
     {
-        auto fs = mtlm.fs();
-
         auto sun = mtl::ParamBuffer::create(
             "Sun", mtl::ParamLayout()
                 .addVec3("Direction")
@@ -64,45 +267,44 @@ struct Scene
         sun->setParam("ShadowColor", vec4(vec3(.5f), 1));
         sun->setParam("Brightness", 3);
 
-        materials.opaque       = mtlm.getMaterial("Materials/opaque.mtl");
-        materials.transparent  = mtlm.getMaterial("Materials/trans.mtl");
-        materials.translucent  = mtlm.getMaterial("Materials/leaves.mtl");
-        materials.flags        = mtlm.getMaterial("Materials/flags.mtl");
+        // Everything is read and checked on the loader's workers,
+        // while uploads run here as soon as each file is in. Shaders
+        // compile in the background until the batch ends.
+        mtlm.beginBatch();
 
-        materials.sky          = mtlm.getMaterial("Materials/sky.mtl");
-        materials.quasicrystal = mtlm.getMaterial("Materials/quasicrystal.mtl");
+        mtlm.loadMaterial("Materials/opaque.mtl",       materials.opaque);
+        mtlm.loadMaterial("Materials/trans.mtl",        materials.transparent);
+        mtlm.loadMaterial("Materials/leaves.mtl",       materials.translucent);
+        mtlm.loadMaterial("Materials/flags.mtl",        materials.flags);
 
+        mtlm.loadMaterial("Materials/sky.mtl",          materials.sky);
+        mtlm.loadMaterial("Materials/quasicrystal.mtl", materials.quasicrystal);
 
-        meshm.loadStatic(fs->openReader("Meshes/opaque.mesh"), meshes.opaque);
-        meshm.loadStatic(fs->openReader("Meshes/trans.mesh"),  meshes.transparent);
-        meshm.loadStatic(fs->openReader("Meshes/leaves.mesh"), meshes.translucent);
-        meshm.loadStatic(fs->openReader("Meshes/flags.mesh"),  meshes.flags);
 
-        meshm.loadStatic(fs->openReader("Meshes/sky.mesh"),    meshes.sky);
-        meshm.loadStatic(fs->openReader("Meshes/gates.mesh"),  meshes.gates);
+        meshm.loadStaticAsync(loader, "Meshes/opaque.mesh", meshes.opaque);
+        meshm.loadStaticAsync(loader, "Meshes/trans.mesh",  meshes.transparent);
+        meshm.loadStaticAsync(loader, "Meshes/leaves.mesh", meshes.translucent);
+        meshm.loadStaticAsync(loader, "Meshes/flags.mesh",  meshes.flags);
+
+        meshm.loadStaticAsync(loader, "Meshes/sky.mesh",    meshes.sky);
+        meshm.loadStaticAsync(loader, "Meshes/gates.mesh",  meshes.gates);
+
+        loader.finish();
+        mtlm.endBatch();
     }
 
-    void render(Renderer& renderer)
+    void render(Renderer& renderer, RenderQueue& queue)
     {
         renderer.clear();
 
-        renderer.setActiveMaterial(materials.opaque);
-        renderer.drawMesh(meshes.opaque);
-
-        renderer.setActiveMaterial(materials.sky);
-        renderer.drawMesh(meshes.sky);
-
-        renderer.setActiveMaterial(materials.flags);
-        renderer.drawMesh(meshes.flags);
-
-        renderer.setActiveMaterial(materials.transparent);
-        renderer.drawMesh(meshes.transparent);
+        queue.submit(materials.opaque,       meshes.opaque);
+        queue.submit(materials.sky,          meshes.sky);
+        queue.submit(materials.flags,        meshes.flags);
+        queue.submit(materials.transparent,  meshes.transparent);
+        queue.submit(materials.translucent,  meshes.translucent);
+        queue.submit(materials.quasicrystal, meshes.gates);
 
-        renderer.setActiveMaterial(materials.translucent);
-        renderer.drawMesh(meshes.translucent);
-
-        renderer.setActiveMaterial(materials.quasicrystal);
-        renderer.drawMesh(meshes.gates);
+        queue.flush(renderer);
     }
 };
 
@@ -113,7 +315,9 @@ struct Scene
 class Demo
 {
 public:
-    Demo()
+    Demo(const Options& options):
+        m_options(options),
+        m_loader(m_mtlm.fs())
     {
         g_log->setStream(m_mtlm.fs()->openWriter("output.log", false));
         g_log->setVerbosity(Log::Debug);
@@ -125,8 +329,15 @@ public:
             std::abort();
         }
 
+        // A packed copy of the data, made by massacre-pack, is used where present
+        m_mtlm.fs()->mount("data.mpk");
+
         m_config.load(m_mtlm.fs()->openReader("mainconf.yaml"));
 
+        // Used only if the directory has been created in the data root
+        if (m_mtlm.setCacheDir("cache"))
+            g_log->info("Material cache enabled");
+
         m_config.query("velocity",   m_velocity,  200.f);
         m_config.query("turn_speed", m_turnSpeed, 60.f);
 
@@ -142,29 +353,46 @@ public:
 
         m_mtlm.addParamBuffer(m_camera.paramBuffer());
         m_mtlm.addParamBuffer(m_commonParams);
+        m_mtlm.setAsyncLoader(&m_loader);
 
         m_timer.start();
-        m_scene.load(m_mtlm, m_meshm);
+        m_scene.load(m_mtlm, m_meshm, m_loader);
         m_timer.refresh();
 
-        g_log->info("Scene load time: %f seconds", m_timer.seconds());
+        m_loadSeconds = m_timer.seconds();
+        g_log->info("Scene load time: %f seconds", m_loadSeconds);
+
+        logPoolStats("Static vertex pool", m_meshm.staticVertexMem().stats());
+        logPoolStats("Static index pool",  m_meshm.staticIndexMem().stats());
     }
 
-    void run()
+    //! False if the benchmark couldn't run or report
+    bool run()
     {
+        if (m_options.benchmarkPath)
+            return runBenchmark();
+
+        constexpr Name timeParam("Time"), deltaTimeParam("DeltaTime");
+
         while (handleEvents())
         {
             handleKeys();
 
             m_timer.refresh();
-            m_commonParams->setParam("Time", m_timer.seconds());
-            m_commonParams->setParam("DeltaTime", m_timer.dseconds());
+            m_commonParams->setParam(timeParam, m_timer.seconds());
+            m_commonParams->setParam(deltaTimeParam, m_timer.dseconds());
 
             if (m_timer.dmilliseconds() >= 17)
                 g_log->debug("Frame time: %llu", m_timer.dmilliseconds());
 
+            m_loader.pump(2000); // anything streamed in meanwhile
+
             m_camera.dumpMatrices();
-            m_scene.render(m_renderer);
+
+            m_queue.setEye(m_camera.position());
+            m_queue.setFrustum(m_camera.viewFrustum());
+            m_scene.render(m_renderer, m_queue);
+            m_renderer.endFrame();
 
             glfwSwapBuffers(win);
 
@@ -180,6 +408,152 @@ public:
                 m_camera.update();
             }
         }
+
+        logQueueStats();
+        logRenderStats(m_renderer.frameStats());
+
+        return true;
+    }
+
+    //! Replays the camera path at a fixed 60 Hz step, so that every run
+    //! renders the same frames however fast it goes, and reports the timings
+    //! as JSON. The first frames warm the caches up and aren't counted.
+    bool runBenchmark()
+    {
+        constexpr Name timeParam("Time"), deltaTimeParam("DeltaTime");
+
+        const double step = 1. / 60;
+        const int    numWarmupFrames = std::min(30, m_options.numFrames / 10);
+
+        CameraPath path;
+        if (!path.load(m_mtlm.fs()->openReader(m_options.benchmarkPath, false)))
+        {
+            g_log->error("Can't load camera path '%s'", m_options.benchmarkPath);
+            return false;
+        }
+
+        m_renderer.setViewport(m_options.size);
+        m_camera.setAspectRatio((float) m_options.size.x() / m_options.size.y());
+        m_camera.update();
+
+        std::vector<double> frameMs, submitMs;
+        frameMs.reserve(m_options.numFrames);
+        submitMs.reserve(m_options.numFrames);
+
+        RenderTotals renderTotals;
+
+        Timer timer;
+        timer.start();
+
+        for (int frame = -numWarmupFrames; frame < m_options.numFrames; ++frame)
+        {
+            auto time = (frame + numWarmupFrames) * step;
+
+            timer.refresh();
+            auto frameStart = timer.microseconds();
+
+            m_commonParams->setParam(timeParam, (float) time);
+            m_commonParams->setParam(deltaTimeParam, (float) step);
+
+            path.sample(time, m_pos, m_rot);
+            placeCamera();
+
+            m_loader.pump(2000);
+
+            m_camera.dumpMatrices();
+
+            m_queue.setEye(m_camera.position());
+            m_queue.setFrustum(m_camera.viewFrustum());
+            m_scene.render(m_renderer, m_queue);
+            m_renderer.endFrame();
+
+            timer.refresh();
+            auto submitEnd = timer.microseconds();
+
+            // Let the GPU catch up, or the numbers only tell how fast commands queue up
+            if (win)
+                glfwSwapBuffers(win);
+            else
+                headless.finish();
+
+            timer.refresh();
+
+            if (frame >= 0)
+            {
+                submitMs.push_back((submitEnd - frameStart) / 1000.);
+                frameMs.push_back((timer.microseconds() - frameStart) / 1000.);
+                renderTotals.add(m_renderer.frameStats());
+            }
+
+            if (win)
+                glfwPollEvents();
+        }
+
+        FILE* out = m_options.outputFile ? std::fopen(m_options.outputFile, "w") : stdout;
+        if (!out)
+        {
+            g_log->error("Can't write benchmark results to '%s'", m_options.outputFile);
+            return false;
+        }
+
+        std::fprintf(out, "{\n");
+        std::fprintf(out, "  \"path\": \"");
+        printEscaped(out, m_options.benchmarkPath);
+        std::fprintf(out, "\",\n");
+        std::fprintf(out, "  \"frames\": %d,\n", m_options.numFrames);
+        std::fprintf(out, "  \"width\": %d,\n", m_options.size.x());
+        std::fprintf(out, "  \"height\": %d,\n", m_options.size.y());
+        std::fprintf(out, "  \"headless\": %s,\n", win ? "false" : "true");
+        std::fprintf(out, "  \"load_seconds\": %.4f,\n", m_loadSeconds);
+        TimingStats(frameMs).print(out, "frame_ms");
+        std::fprintf(out, ",\n");
+        TimingStats(submitMs).print(out, "submit_ms");
+        std::fprintf(out, ",\n");
+        renderTotals.print(out, "render_stats");
+        std::fprintf(out, "\n}\n");
+
+        if (out != stdout)
+            std::fclose(out);
+
+        logQueueStats();
+        logRenderStats(m_renderer.frameStats());
+        return true;
+    }
+
+    void logQueueStats()
+    {
+        auto& stats = m_queue.stats();
+
+        g_log->info("Render queue: %u draws, %u culled; switches issued/avoided: "
+                    "%u/%u materials, %u/%u programs, %u/%u textures, %u/%u buffers, %u/%u render states",
+            stats.numDraws, stats.numCulled,
+            stats.issued.materials,    stats.avoided.materials,
+            stats.issued.programs,     stats.avoided.programs,
+            stats.issued.textures,     stats.avoided.textures,
+            stats.issued.buffers,      stats.avoided.buffers,
+            stats.issued.renderStates, stats.avoided.renderStates);
+    }
+
+    static void logRenderStats(const RenderStats& stats)
+    {
+        g_log->info("Last frame: %u draws, %llu triangles; binds issued/skipped: "
+                    "%u/%u programs, %u/%u textures, %u/%u buffers, %u/%u vertex arrays; "
+                    "%u render state changes, %u uniforms, %llu parameter bytes, %llu buffer bytes",
+            stats.numDraws, (unsigned long long) stats.numTriangles,
+            stats.issued.programs,     stats.skipped.programs,
+            stats.issued.textures,     stats.skipped.textures,
+            stats.issued.buffers,      stats.skipped.buffers,
+            stats.issued.vertexArrays, stats.skipped.vertexArrays,
+            stats.renderStateChanges, stats.numUniforms,
+            (unsigned long long) stats.paramBytes, (unsigned long long) stats.bufferBytes);
+    }
+
+    static void logPoolStats(const char* name, const geom::mem::PooledMemory::Stats& stats)
+    {
+        g_log->info("%s: %u allocations in %u pages, %u of %u KB used, %u free blocks (fragmentation %.2f)",
+            name, (uint) stats.numAllocations, (uint) stats.numPages,
+            (uint) (stats.bytesUsed >> 10), (uint) (stats.bytesReserved >> 10),
+            (uint) stats.numFreeBlocks, stats.fragmentation());
     }
 
     static void measureFps()
@@ -216,7 +590,11 @@ public:
         m_pos += dtime * m_velocity * movementControl;
         m_rot += vec3(0, dtime * m_turnSpeed * rotationControl, 0);
 
+        placeCamera();
+    }
 
+    void placeCamera()
+    {
         static const vec3 camOffset(0, 35, 0);
 
         auto rotation = math::buildTransform(vec3(), m_rot);
@@ -237,13 +615,17 @@ public:
     }
 
 private:
+    Options                 m_options;
     Config                  m_config;
     Timer                   m_timer;
+    double                  m_loadSeconds;
 
     Renderer                m_renderer;
+    RenderQueue             m_queue;
     Camera                  m_camera;
 
     mtl::Manager            m_mtlm;
+    AsyncLoader             m_loader;
     rcptr<mtl::ParamBuffer> m_commonParams;
     geom::MeshManager       m_meshm;
     Scene                   m_scene;
@@ -290,10 +672,94 @@ void initWindow(int w, int h)
     glfwSwapInterval(0);
 }
 
-int main()
+// massacre-demo [--benchmark <camera path>] [--frames <n>] [--output <json file>]
+//               [--size <w>x<h>] [--headless] [--profile <trace file>]
+//
+// The camera path is looked up in the data directory; --headless needs no
+// display and implies a benchmark (of "benchmark.path" unless given).
+// --profile writes a Chrome trace of loading and the frames on exit.
+bool parseOptions(int argc, char** argv, Options& options)
+{
+    for (int i = 1; i < argc; ++i)
+    {
+        auto arg   = argv[i];
+        auto value = i + 1 < argc ? argv[i + 1] : nullptr;
+
+        if (!std::strcmp(arg, "--headless"))
+        {
+            options.headless = true;
+            continue;
+        }
+
+        if (!value)
+            return false;
+
+        if (!std::strcmp(arg, "--benchmark"))
+            options.benchmarkPath = value;
+        else if (!std::strcmp(arg, "--output"))
+            options.outputFile = value;
+        else if (!std::strcmp(arg, "--profile"))
+            options.profileFile = value;
+        else if (!std::strcmp(arg, "--frames"))
+            options.numFrames = std::max(1, std::atoi(value));
+        else if (!std::strcmp(arg, "--size"))
+        {
+            if (std::sscanf(value, "%dx%d", &options.size[0], &options.size[1]) != 2
+            ||  options.size.x() <= 0 || options.size.y() <= 0)
+                return false;
+        }
+        else
+            return false;
+
+        ++i;
+    }
+
+    if (options.headless && !options.benchmarkPath)
+        options.benchmarkPath = "benchmark.path";
+
+    return true;
+}
+
+int main(int argc, char** argv)
 {
-    initWindow(1024, 768);
+    Options options;
+
+    if (!parseOptions(argc, argv, options))
+    {
+        std::fprintf(stderr, "usage: massacre-demo [--benchmark <camera path>] [--frames <n>] "
+                             "[--output <json file>] [--size <w>x<h>] [--headless] [--profile <trace file>]\n");
+        return 1;
+    }
+
+    if (!options.headless)
+        initWindow(options.size.x(), options.size.y());
+    else if (!headless.create(options.size))
+        return 1;
+
+    if (options.profileFile)
+    {
+        Profiler::setEnabled(true);
+        Profiler::setThreadName("Main");
+    }
+
+    bool ok;
+
+    {
+        Demo app(options);
+        ok = app.run();
+    }
+
+    if (options.profileFile)
+    {
+        io::FileSystem fs;
+        fs.setRoot(io::Path::dir(options.profileFile).c_str());
+
+        if (!Profiler::writeChromeTrace(fs.openWriter(io::Path::filename(options.profileFile))))
+        {
+            std::fprintf(stderr, "Can't write trace to '%s'\n", options.profileFile);
+            ok = false;
+        }
+    }
 
-    Demo app;
-    app.run();
+    return ok ? 0 : 1;
 }
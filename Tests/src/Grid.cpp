@@ -0,0 +1,85 @@
+// GridDimension::cellAt() around shared offsets and unset axes
+
+#include <cstdio>
+#include <mcr/math/Grid.h>
+
+using namespace mcr;
+using namespace math;
+
+namespace {
+
+int g_failures = 0;
+
+void check(bool ok, const char* what)
+{
+    if (!ok)
+    {
+        std::fprintf(stderr, "FAILED: %s\n", what);
+        ++g_failures;
+    }
+}
+
+#define CHECK(cond) check(cond, #cond)
+
+bool cellIs(const GridDimension& dim, float pos, uint first, uint second)
+{
+    uvec2 axes;
+    return dim.cellAt(pos, axes) && axes == uvec2(first, second);
+}
+
+bool noCell(const GridDimension& dim, float pos)
+{
+    uvec2 axes;
+    return !dim.cellAt(pos, axes);
+}
+
+} // ns
+
+int main()
+{
+    // Axes 1 and 2 share an offset, so there's no cell between them
+    {
+        GridDimension dim;
+        dim.setRange(vec2(0, 100));
+        dim.insertAxis(0, 0.f);
+        dim.insertAxis(1, percents(50));
+        dim.insertAxis(2, percents(50));
+        dim.insertAxis(3, limit());
+
+        CHECK(cellIs(dim, 10, 0, 1));
+        CHECK(cellIs(dim, 50, 2, 3));
+        CHECK(cellIs(dim, 75, 2, 3));
+        CHECK(noCell(dim, -1));
+        CHECK(noCell(dim, 100));
+    }
+
+    // Axis 1 is never set and bounds nothing
+    {
+        GridDimension dim;
+        dim.setRange(vec2(0, 100));
+        dim.insertAxis(0, 0.f);
+        dim.insertAxis(2, percents(50));
+        dim.insertAxis(3, limit());
+
+        CHECK(cellIs(dim, 0, 0, 2));
+        CHECK(cellIs(dim, 10, 0, 2));
+        CHECK(cellIs(dim, 50, 2, 3));
+    }
+
+    // Removed axes drop out the same way
+    {
+        GridDimension dim;
+        dim.setRange(vec2(0, 100));
+        dim.insertAxis(0, 0.f);
+        dim.insertAxis(1, percents(25));
+        dim.insertAxis(2, limit());
+
+        CHECK(cellIs(dim, 10, 0, 1));
+
+        dim.removeAxis(1);
+
+        CHECK(cellIs(dim, 10, 0, 2));
+    }
+
+    return g_failures ? 1 : 0;
+}
@@ -0,0 +1,192 @@
+// Packs a data directory into an archive that io::FileSystem can mount:
+//
+//     massacre-pack [-z] [-a alignment] <data dir> <archive>
+//
+// Entry names are paths relative to the data directory, with forward slashes
+
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <vector>
+
+#include <mcr/Platform.h>
+#include <mcr/io/Archive.h>
+#include <mcr/io/FileSystem.h>
+
+#if defined(MCR_PLATFORM_WINDOWS)
+#   define WIN32_LEAN_AND_MEAN
+#   define NOMINMAX
+#   include <Windows.h>
+#else
+#   include <sys/stat.h>
+#   include <dirent.h>
+#endif
+
+using namespace mcr;
+
+namespace {
+
+//! Append the files below \c root + \c dir to \c files, relative to \c root
+void listFiles(const std::string& root, const std::string& dir, std::vector<std::string>& files)
+{
+#if defined(MCR_PLATFORM_WINDOWS)
+
+    WIN32_FIND_DATAA data;
+    HANDLE find = FindFirstFileA((root + dir + "*").c_str(), &data);
+
+    if (find == INVALID_HANDLE_VALUE)
+        return;
+
+    do
+    {
+        std::string name = data.cFileName;
+
+        if (name == "." || name == "..")
+            continue;
+
+        if (data.dwFileAttributes & FILE_ATTRIBUTE_DIRECTORY)
+            listFiles(root, dir + name + "/", files);
+        else
+            files.push_back(dir + name);
+    }
+    while (FindNextFileA(find, &data));
+
+    FindClose(find);
+
+#else
+
+    auto handle = opendir((root + dir).c_str());
+    if (!handle)
+        return;
+
+    while (auto entry = readdir(handle))
+    {
+        std::string name = entry->d_name;
+
+        if (name == "." || name == "..")
+            continue;
+
+        struct stat st;
+        if (stat((root + dir + name).c_str(), &st) != 0)
+            continue;
+
+        if (S_ISDIR(st.st_mode))
+            listFiles(root, dir + name + "/", files);
+        else if (S_ISREG(st.st_mode))
+            files.push_back(dir + name);
+    }
+
+    closedir(handle);
+
+#endif
+}
+
+//! Whether both paths name the same existing file, however they're spelled
+bool sameFile(const std::string& a, const std::string& b)
+{
+#if defined(MCR_PLATFORM_WINDOWS)
+
+    char fullA[MAX_PATH], fullB[MAX_PATH];
+
+    return GetFullPathNameA(a.c_str(), MAX_PATH, fullA, nullptr)
+        && GetFullPathNameA(b.c_str(), MAX_PATH, fullB, nullptr)
+        && !_stricmp(fullA, fullB);
+
+#else
+
+    struct stat stA, stB;
+
+    return stat(a.c_str(), &stA) == 0 && stat(b.c_str(), &stB) == 0
+        && stA.st_dev == stB.st_dev && stA.st_ino == stB.st_ino;
+
+#endif
+}
+
+int usage()
+{
+    std::fprintf(stderr, "usage: massacre-pack [-z] [-a alignment] <data dir> <archive>\n");
+    return 1;
+}
+
+} // ns
+
+
+int main(int argc, char** argv)
+{
+    bool compress  = false;
+    uint alignment = 16;
+
+    int arg = 1;
+
+    for (; arg < argc && argv[arg][0] == '-'; ++arg)
+    {
+        if (!std::strcmp(argv[arg], "-z"))
+            compress = true;
+        else if (!std::strcmp(argv[arg], "-a") && arg + 1 < argc)
+            alignment = (uint) std::atoi(argv[++arg]);
+        else
+            return usage();
+    }
+
+    if (argc - arg != 2)
+        return usage();
+
+    io::FileSystem fs;
+
+    if (!fs.setRoot(argv[arg]))
+    {
+        std::fprintf(stderr, "massacre-pack: no directory '%s'\n", argv[arg]);
+        return 1;
+    }
+
+    std::vector<std::string> files;
+    listFiles(fs.root(), "", files);
+    std::sort(files.begin(), files.end());
+
+    // Don't pack a previous version of the archive into the new one
+    auto output = io::Path::format(argv[arg + 1]);
+
+    io::ArchiveBuilder builder(alignment);
+    uint64 totalSize = 0;
+
+    for (auto it = files.begin(); it != files.end(); ++it)
+    {
+        if (sameFile(fs.root() + *it, output))
+            continue;
+
+        auto file = fs.openReader(it->c_str());
+        if (!file)
+        {
+            std::fprintf(stderr, "massacre-pack: can't read '%s'\n", it->c_str());
+            return 1;
+        }
+
+        std::vector<byte> data((std::size_t) file->size());
+
+        if (!data.empty() && file->read(&data[0], data.size()) != data.size())
+        {
+            std::fprintf(stderr, "massacre-pack: can't read '%s'\n", it->c_str());
+            return 1;
+        }
+
+        builder.add(it->c_str(), data.empty() ? nullptr : &data[0], data.size(), compress);
+        totalSize += data.size();
+    }
+
+    io::FileSystem outFs;
+    outFs.setRoot(io::Path::dir(output.c_str()).c_str());
+
+    auto out = outFs.openWriter(io::Path::filename(output.c_str()));
+
+    if (!out || !builder.write(out))
+    {
+        std::fprintf(stderr, "massacre-pack: can't write '%s'\n", output.c_str());
+        return 1;
+    }
+
+    std::printf("%u files, %llu bytes packed into %s (%llu bytes)\n", (uint) builder.numEntries(),
+                (unsigned long long) totalSize, output.c_str(), (unsigned long long) out->tell());
+    return 0;
+}
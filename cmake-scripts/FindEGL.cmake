@@ -0,0 +1,22 @@
+#
+# Try to find EGL library and include path.
+# Once done this will define
+#
+# EGL_FOUND
+# EGL_INCLUDE_DIRS
+# EGL_LIBRARIES
+# 
+
+find_path(EGL_INCLUDE_DIRS EGL/egl.h)
+find_library(EGL_LIBRARY EGL)
+
+include(FindPackageHandleStandardArgs)
+FIND_PACKAGE_HANDLE_STANDARD_ARGS(
+    EGL DEFAULT_MSG
+    EGL_INCLUDE_DIRS EGL_LIBRARY)
+
+if(EGL_FOUND)
+    set(EGL_LIBRARIES ${EGL_LIBRARY})
+endif()
+
+mark_as_advanced(EGL_INCLUDE_DIRS EGL_LIBRARIES EGL_LIBRARY)